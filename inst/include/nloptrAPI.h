@@ -24,176 +24,199 @@
  * accessed by external R packages.
  *
  * 03/10/2017: Initial version exposing nlopt_version.
+ * 18/10/2026: Exposed nloptr_async_* to run optimizations on a background
+ *             thread.
+ * 18/10/2026: Resolve all functions at once through the versioned table of
+ *             nloptrTable.h.
+ * 18/10/2026: Exposed nloptr_check_gradient to check sampled components or
+ *             directional derivatives of a gradient.
+ * 18/10/2026: Exposed nloptr_sobol and nloptr_sobol_screen to generate and
+ *             screen Sobol sequences.
+ * 18/10/2026: Cache the table of nloptr_api_table() in an atomic pointer.
 */
 
 #ifndef __NLOPTRAPI_H__
 #define __NLOPTRAPI_H__
 
+/*
+ * The cached table is an atomic pointer: std::atomic in C++11, _Atomic in C11,
+ * or the __atomic builtins of GCC and clang otherwise. Other compilers get a
+ * plain pointer, which is only safe if the first call to nloptr_api_table() is
+ * made before the threads using it are started (see below). The standard
+ * headers come before those of R, which remap some names.
+ */
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#include <atomic>
+#define NLOPTR_API_CXX11_ATOMICS
+#elif !defined(__cplusplus) && defined(__STDC_VERSION__) && \
+    __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define NLOPTR_API_C11_ATOMICS
+#elif defined(__GNUC__) || defined(__clang__)
+#define NLOPTR_API_GNUC_ATOMICS
+#endif
+
 #include <R_ext/Rdynload.h>
 #include <R.h>
 #include <Rinternals.h>
 
 #include "nlopt.h"
+#include "nloptrTable.h"
 
 /*
- * C functions can be exposed using the following template:
+ * All functions are resolved at once: nloptr_api_table() looks up the table of
+ * function pointers registered by nloptr on its first call and caches it. The
+ * lookup calls the R API, so the first call must be made from the main R
+ * thread, typically in the R_init_<pkg> function of the calling package,
+ * before any thread using the table is started; after that, the table can be
+ * used from any thread. The version and the capabilities of the installed
+ * nloptr are given by the version and capabilities members of the table.
+ *
+ * C functions can be exposed using the following template, after appending
+ * their pointer to the nloptr_api table:
  *
  * RET_TYPE FUNCNAME(ARGTYPE_1 ARGNAME 1, ARGTYPE_2 ARGNAME_2)
  * {
- *     static RET_TYPE(*fun)(ARGTYPE_1, ARGTYPE_2) = NULL;
- *     if (fun == NULL) fun = (RET_TYPE(*)(ARGTYPE_1, ARGTYPE_2)) R_GetCCallable("nloptr","FUNCNAME");
- *     return fun(ARGNAME_1, ARGNAME_2);
+ *     return nloptr_api_table()->FUNCNAME(ARGNAME_1, ARGNAME_2);
  * }
  *
 */
 
+static inline const nloptr_api *nloptr_api_table(void)
+{
+#if defined(NLOPTR_API_CXX11_ATOMICS)
+    static std::atomic<const nloptr_api *> api(NULL);
+    const nloptr_api *table = api.load(std::memory_order_acquire);
+#elif defined(NLOPTR_API_C11_ATOMICS)
+    static _Atomic(const nloptr_api *) api = NULL;
+    const nloptr_api *table = atomic_load_explicit(&api, memory_order_acquire);
+#elif defined(NLOPTR_API_GNUC_ATOMICS)
+    static const nloptr_api *api = NULL;
+    const nloptr_api *table = __atomic_load_n(&api, __ATOMIC_ACQUIRE);
+#else
+    static const nloptr_api *api = NULL;
+    const nloptr_api *table = api;
+#endif
+    if (table == NULL) {
+        table = ((const nloptr_api *(*)(void)) R_GetCCallable("nloptr","nloptr_get_api"))();
+#if defined(NLOPTR_API_CXX11_ATOMICS)
+        api.store(table, std::memory_order_release);
+#elif defined(NLOPTR_API_C11_ATOMICS)
+        atomic_store_explicit(&api, table, memory_order_release);
+#elif defined(NLOPTR_API_GNUC_ATOMICS)
+        __atomic_store_n(&api, table, __ATOMIC_RELEASE);
+#else
+        api = table;
+#endif
+    }
+    return table;
+}
+
 inline NLOPT_EXTERN(const char *) nlopt_algorithm_name(nlopt_algorithm a)
 {
-    static const char *(*fun)(nlopt_algorithm) = NULL;
-    if (fun == NULL) fun = (const char *(*)(nlopt_algorithm)) R_GetCCallable("nloptr","nlopt_algorithm_name");
-    return fun(a);
+    return nloptr_api_table()->nlopt_algorithm_name(a);
 }
 
 inline NLOPT_EXTERN(void) nlopt_srand(unsigned long seed)
 {
-    static void(*fun)(unsigned long) = NULL;
-    if (fun == NULL) fun = (void(*)(unsigned long)) R_GetCCallable("nloptr","nlopt_srand");
-    return fun(seed);
+    return nloptr_api_table()->nlopt_srand(seed);
 }
 
 inline NLOPT_EXTERN(void) nlopt_srand_time(void)
 {
-    static void(*fun)(void) = NULL;
-    if (fun == NULL) fun = (void(*)(void)) R_GetCCallable("nloptr","nlopt_srand_time");
-    return fun();
+    return nloptr_api_table()->nlopt_srand_time();
 }
 
 inline NLOPT_EXTERN(void) nlopt_version(int *major, int *minor, int *bugfix)
 {
-    static void(*fun)(int *, int *, int *) = NULL;
-    if (fun == NULL) fun = (void(*)(int *, int *, int *)) R_GetCCallable("nloptr","nlopt_version");
-    return fun(major, minor, bugfix);
+    return nloptr_api_table()->nlopt_version(major, minor, bugfix);
 }
 
 inline NLOPT_EXTERN(nlopt_opt) nlopt_create(nlopt_algorithm algorithm, unsigned n)
 {
-    static nlopt_opt(*fun)(nlopt_algorithm, unsigned) = NULL;
-    if (fun == NULL) fun = (nlopt_opt(*)(nlopt_algorithm, unsigned)) R_GetCCallable("nloptr","nlopt_create");
-    return fun(algorithm, n);
+    return nloptr_api_table()->nlopt_create(algorithm, n);
 }
 
 inline NLOPT_EXTERN(void) nlopt_destroy(nlopt_opt opt)
 {
-    static void(*fun)(nlopt_opt) = NULL;
-    if (fun == NULL) fun = (void(*)(nlopt_opt)) R_GetCCallable("nloptr","nlopt_destroy");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_destroy(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_opt) nlopt_copy(const nlopt_opt opt)
 {
-    static nlopt_opt(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_opt(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_copy");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_copy(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_optimize(nlopt_opt opt, double *x, double *opt_f)
 {
-    static nlopt_result(*fun)(nlopt_opt, double *, double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double *, double *)) R_GetCCallable("nloptr","nlopt_optimize");
-    return fun(opt, x, opt_f);
+    return nloptr_api_table()->nlopt_optimize(opt, x, opt_f);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_min_objective(nlopt_opt opt, nlopt_func f, void *f_data)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, void *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, void *)) R_GetCCallable("nloptr","nlopt_set_min_objective");
-    return fun(opt, f, f_data);
+    return nloptr_api_table()->nlopt_set_min_objective(opt, f, f_data);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_max_objective(nlopt_opt opt, nlopt_func f, void *f_data)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, void *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, void *)) R_GetCCallable("nloptr","nlopt_set_max_objective");
-    return fun(opt, f, f_data);
+    return nloptr_api_table()->nlopt_set_max_objective(opt, f, f_data);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_precond_min_objective(nlopt_opt opt, nlopt_func f, nlopt_precond pre, void *f_data)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, nlopt_precond, void *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, nlopt_precond, void *)) R_GetCCallable("nloptr","nlopt_set_precond_min_objective");
-    return fun(opt, f, pre, f_data);
+    return nloptr_api_table()->nlopt_set_precond_min_objective(opt, f, pre, f_data);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_precond_max_objective(nlopt_opt opt, nlopt_func f, nlopt_precond pre, void *f_data)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, nlopt_precond, void *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, nlopt_precond, void *)) R_GetCCallable("nloptr","nlopt_set_precond_max_objective");
-    return fun(opt, f, pre, f_data);
+    return nloptr_api_table()->nlopt_set_precond_max_objective(opt, f, pre, f_data);
 }
 
 inline NLOPT_EXTERN(nlopt_algorithm) nlopt_get_algorithm(const nlopt_opt opt)
 {
-    static nlopt_algorithm(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_algorithm(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_algorithm");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_algorithm(opt);
 }
 
 inline NLOPT_EXTERN(unsigned) nlopt_get_dimension(const nlopt_opt opt)
 {
-    static unsigned(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (unsigned(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_dimension");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_dimension(opt);
 }
 
 /* constraints: */
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_lower_bounds(nlopt_opt opt, const double *lb)
 {
-    static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_lower_bounds");
-    return fun(opt, lb);
+    return nloptr_api_table()->nlopt_set_lower_bounds(opt, lb);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_lower_bounds1(nlopt_opt opt, double lb)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_lower_bounds1");
-    return fun(opt, lb);
+    return nloptr_api_table()->nlopt_set_lower_bounds1(opt, lb);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_get_lower_bounds(const nlopt_opt opt, double *lb)
 {
-    static nlopt_result(*fun)(const nlopt_opt, double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(const nlopt_opt, double *)) R_GetCCallable("nloptr","nlopt_get_lower_bounds");
-    return fun(opt, lb);
+    return nloptr_api_table()->nlopt_get_lower_bounds(opt, lb);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_upper_bounds(nlopt_opt opt, const double *ub)
 {
-    static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_upper_bounds");
-    return fun(opt, ub);
+    return nloptr_api_table()->nlopt_set_upper_bounds(opt, ub);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_upper_bounds1(nlopt_opt opt, double ub)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_upper_bounds1");
-    return fun(opt, ub);
+    return nloptr_api_table()->nlopt_set_upper_bounds1(opt, ub);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_get_upper_bounds(const nlopt_opt opt, double *ub)
 {
-    static nlopt_result(*fun)(const nlopt_opt, double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(const nlopt_opt, double *)) R_GetCCallable("nloptr","nlopt_get_upper_bounds");
-    return fun(opt, ub);
+    return nloptr_api_table()->nlopt_get_upper_bounds(opt, ub);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_remove_inequality_constraints(nlopt_opt opt)
 {
-    static nlopt_result(*fun)(nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt)) R_GetCCallable("nloptr","nlopt_remove_inequality_constraints");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_remove_inequality_constraints(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_inequality_constraint(nlopt_opt opt,
@@ -201,18 +224,14 @@ inline NLOPT_EXTERN(nlopt_result) nlopt_add_inequality_constraint(nlopt_opt opt,
              void *fc_data,
              double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, void *, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, void *, double)) R_GetCCallable("nloptr","nlopt_add_inequality_constraint");
-    return fun(opt, fc, fc_data, tol);
+    return nloptr_api_table()->nlopt_add_inequality_constraint(opt, fc, fc_data, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_precond_inequality_constraint(
         nlopt_opt opt, nlopt_func fc, nlopt_precond pre, void *fc_data,
         double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, nlopt_precond, void *, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, nlopt_precond, void *, double)) R_GetCCallable("nloptr","nlopt_add_precond_inequality_constraint");
-    return fun(opt, fc, pre, fc_data, tol);
+    return nloptr_api_table()->nlopt_add_precond_inequality_constraint(opt, fc, pre, fc_data, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_inequality_mconstraint(nlopt_opt opt,
@@ -221,16 +240,12 @@ inline NLOPT_EXTERN(nlopt_result) nlopt_add_inequality_mconstraint(nlopt_opt opt
              void *fc_data,
              const double *tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, unsigned, nlopt_mfunc, void *, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, unsigned, nlopt_mfunc, void *, const double *)) R_GetCCallable("nloptr","nlopt_add_inequality_mconstraint");
-    return fun(opt, m, fc, fc_data, tol);
+    return nloptr_api_table()->nlopt_add_inequality_mconstraint(opt, m, fc, fc_data, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_remove_equality_constraints(nlopt_opt opt)
 {
-    static nlopt_result(*fun)(nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt)) R_GetCCallable("nloptr","nlopt_remove_equality_constraints");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_remove_equality_constraints(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_equality_constraint(nlopt_opt opt,
@@ -238,18 +253,14 @@ inline NLOPT_EXTERN(nlopt_result) nlopt_add_equality_constraint(nlopt_opt opt,
              void *h_data,
              double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, void *, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, void *, double)) R_GetCCallable("nloptr","nlopt_add_equality_constraint");
-    return fun(opt, h, h_data, tol);
+    return nloptr_api_table()->nlopt_add_equality_constraint(opt, h, h_data, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_precond_equality_constraint(
         nlopt_opt opt, nlopt_func h, nlopt_precond pre, void *h_data,
         double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, nlopt_func, nlopt_precond, void *, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, nlopt_func, nlopt_precond, void *, double)) R_GetCCallable("nloptr","nlopt_add_precond_equality_constraint");
-    return fun(opt, h, pre, h_data, tol);
+    return nloptr_api_table()->nlopt_add_precond_equality_constraint(opt, h, pre, h_data, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_add_equality_mconstraint(nlopt_opt opt,
@@ -258,223 +269,256 @@ inline NLOPT_EXTERN(nlopt_result) nlopt_add_equality_mconstraint(nlopt_opt opt,
              void *h_data,
              const double *tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, unsigned, nlopt_mfunc, void *, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, unsigned, nlopt_mfunc, void *, const double *)) R_GetCCallable("nloptr","nlopt_add_equality_mconstraint");
-    return fun(opt, m, h, h_data, tol);
+    return nloptr_api_table()->nlopt_add_equality_mconstraint(opt, m, h, h_data, tol);
 }
 
 /* stopping criteria: */
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_stopval(nlopt_opt opt, double stopval)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_stopval");
-    return fun(opt, stopval);
+    return nloptr_api_table()->nlopt_set_stopval(opt, stopval);
 }
 
 inline NLOPT_EXTERN(double) nlopt_get_stopval(const nlopt_opt opt)
 {
-    static double(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (double(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_stopval");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_stopval(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_ftol_rel(nlopt_opt opt, double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_ftol_rel");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_set_ftol_rel(opt, tol);
 }
 
 inline NLOPT_EXTERN(double) nlopt_get_ftol_rel(const nlopt_opt opt)
 {
-    static double(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (double(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_ftol_rel");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_ftol_rel(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_ftol_abs(nlopt_opt opt, double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_ftol_abs");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_set_ftol_abs(opt, tol);
 }
 
 inline NLOPT_EXTERN(double) nlopt_get_ftol_abs(const nlopt_opt opt)
 {
-    static double(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (double(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_ftol_abs");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_ftol_abs(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_xtol_rel(nlopt_opt opt, double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_xtol_rel");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_set_xtol_rel(opt, tol);
 }
 
 inline NLOPT_EXTERN(double) nlopt_get_xtol_rel(const nlopt_opt opt)
 {
-    static double(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (double(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_xtol_rel");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_xtol_rel(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_xtol_abs1(nlopt_opt opt, double tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_xtol_abs1");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_set_xtol_abs1(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_xtol_abs(nlopt_opt opt, const double *tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_xtol_abs");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_set_xtol_abs(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_get_xtol_abs(const nlopt_opt opt, double *tol)
 {
-    static nlopt_result(*fun)(nlopt_opt, double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double *)) R_GetCCallable("nloptr","nlopt_get_xtol_abs");
-    return fun(opt, tol);
+    return nloptr_api_table()->nlopt_get_xtol_abs(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_x_weights1(nlopt_opt opt, double tol)
 {
-  static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-  if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_x_weights1");
-  return fun(opt, tol);
+  return nloptr_api_table()->nlopt_set_x_weights1(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_x_weights(nlopt_opt opt, const double *tol)
 {
-  static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-  if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_x_weights");
-  return fun(opt, tol);
+  return nloptr_api_table()->nlopt_set_x_weights(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_get_x_weights(const nlopt_opt opt, double *tol)
 {
-  static nlopt_result(*fun)(nlopt_opt, double *) = NULL;
-  if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double *)) R_GetCCallable("nloptr","nlopt_get_x_weights");
-  return fun(opt, tol);
+  return nloptr_api_table()->nlopt_get_x_weights(opt, tol);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_maxeval(nlopt_opt opt, int maxeval)
 {
-    static nlopt_result(*fun)(nlopt_opt, int) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, int)) R_GetCCallable("nloptr","nlopt_set_maxeval");
-    return fun(opt, maxeval);
+    return nloptr_api_table()->nlopt_set_maxeval(opt, maxeval);
 }
 
 inline NLOPT_EXTERN(int) nlopt_get_maxeval(const nlopt_opt opt)
 {
-    static int(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (int(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_maxeval");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_maxeval(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_maxtime(nlopt_opt opt, double maxtime)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_maxtime");
-    return fun(opt, maxtime);
+    return nloptr_api_table()->nlopt_set_maxtime(opt, maxtime);
 }
 
 inline NLOPT_EXTERN(double) nlopt_get_maxtime(const nlopt_opt opt)
 {
-    static double(*fun)(nlopt_opt) = NULL;
-    if (fun == NULL) fun = (double(*)(nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_maxtime");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_maxtime(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_force_stop(nlopt_opt opt)
 {
-    static nlopt_result(*fun)(nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt)) R_GetCCallable("nloptr","nlopt_force_stop");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_force_stop(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_force_stop(nlopt_opt opt, int val)
 {
-    static nlopt_result(*fun)(nlopt_opt, int) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, int)) R_GetCCallable("nloptr","nlopt_set_force_stop");
-    return fun(opt, val);
+    return nloptr_api_table()->nlopt_set_force_stop(opt, val);
 }
 
 inline NLOPT_EXTERN(int) nlopt_get_force_stop(const nlopt_opt opt)
 {
-    static int(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (int(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_force_stop");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_force_stop(opt);
 }
 
 /* more algorithm-specific parameters */
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_local_optimizer(nlopt_opt opt, const nlopt_opt local_opt)
 {
-    static nlopt_result(*fun)(nlopt_opt, const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const nlopt_opt)) R_GetCCallable("nloptr","nlopt_set_local_optimizer");
-    return fun(opt, local_opt);
+    return nloptr_api_table()->nlopt_set_local_optimizer(opt, local_opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_population(nlopt_opt opt, unsigned pop)
 {
-    static nlopt_result(*fun)(nlopt_opt, unsigned) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, unsigned)) R_GetCCallable("nloptr","nlopt_set_population");
-    return fun(opt, pop);
+    return nloptr_api_table()->nlopt_set_population(opt, pop);
 }
 
 inline NLOPT_EXTERN(unsigned) nlopt_get_population(const nlopt_opt opt)
 {
-    static unsigned(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (unsigned(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_population");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_population(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_vector_storage(nlopt_opt opt, unsigned dim)
 {
-    static nlopt_result(*fun)(nlopt_opt, unsigned) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, unsigned)) R_GetCCallable("nloptr","nlopt_set_vector_storage");
-    return fun(opt, dim);
+    return nloptr_api_table()->nlopt_set_vector_storage(opt, dim);
 }
 
 inline NLOPT_EXTERN(unsigned) nlopt_get_vector_storage(const nlopt_opt opt)
 {
-    static unsigned(*fun)(const nlopt_opt) = NULL;
-    if (fun == NULL) fun = (unsigned(*)(const nlopt_opt)) R_GetCCallable("nloptr","nlopt_get_vector_storage");
-    return fun(opt);
+    return nloptr_api_table()->nlopt_get_vector_storage(opt);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_default_initial_step(nlopt_opt opt, const double *x)
 {
-    static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_default_initial_step");
-    return fun(opt, x);
+    return nloptr_api_table()->nlopt_set_default_initial_step(opt, x);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_initial_step(nlopt_opt opt, const double *dx)
 {
-    static nlopt_result(*fun)(nlopt_opt, const double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, const double *)) R_GetCCallable("nloptr","nlopt_set_initial_step");
-    return fun(opt, dx);
+    return nloptr_api_table()->nlopt_set_initial_step(opt, dx);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_set_initial_step1(nlopt_opt opt, double dx)
 {
-    static nlopt_result(*fun)(nlopt_opt, double) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(nlopt_opt, double)) R_GetCCallable("nloptr","nlopt_set_initial_step1");
-    return fun(opt, dx);
+    return nloptr_api_table()->nlopt_set_initial_step1(opt, dx);
 }
 
 inline NLOPT_EXTERN(nlopt_result) nlopt_get_initial_step(const nlopt_opt opt, const double *x, double *dx)
 {
-    static nlopt_result(*fun)(const nlopt_opt, const double *, double *) = NULL;
-    if (fun == NULL) fun = (nlopt_result(*)(const nlopt_opt, const double *, double *)) R_GetCCallable("nloptr","nlopt_get_initial_step");
-    return fun(opt, x, dx);
+    return nloptr_api_table()->nlopt_get_initial_step(opt, x, dx);
+}
+
+/*
+ * Asynchronous optimization.
+ *
+ * nloptr_async_start runs nlopt_optimize on a background thread, minimizing f
+ * and returns a handle (NULL on failure). The optimization runs on a copy of
+ * opt, which is left unchanged. f and the constraint functions are called from
+ * that thread and must not call the R API; f_data and the data of the
+ * constraints must stay alive until the handle is collected.
+ *
+ * nloptr_async_poll copies the lowest objective value evaluated so far, the
+ * corresponding point (if x_best is not NULL) and the number of evaluations
+ * (if num_evals is not NULL) without blocking, and returns 1 once the
+ * optimization is over.
+ *
+ * nloptr_async_cancel asks the optimization to stop with NLOPT_FORCED_STOP
+ * after the evaluation in progress.
+ *
+ * nloptr_async_collect waits for the end of the optimization, copies the
+ * solution and its objective value, releases the handle and returns the
+ * status of nlopt_optimize.
+ */
+
+typedef struct nloptr_async_s *nloptr_async;
+
+static inline nloptr_async nloptr_async_start(nlopt_opt opt, nlopt_func f, void *f_data, const double *x0)
+{
+    return nloptr_api_table()->nloptr_async_start(opt, f, f_data, x0);
+}
+
+static inline int nloptr_async_poll(nloptr_async h, double *f_best, double *x_best, unsigned long *num_evals)
+{
+    return nloptr_api_table()->nloptr_async_poll(h, f_best, x_best, num_evals);
+}
+
+static inline void nloptr_async_cancel(nloptr_async h)
+{
+    return nloptr_api_table()->nloptr_async_cancel(h);
+}
+
+static inline nlopt_result nloptr_async_collect(nloptr_async h, double *x, double *opt_f)
+{
+    return nloptr_api_table()->nloptr_async_collect(h, x, opt_f);
+}
+
+/*
+ * Sampled derivative checker (NLOPTR_CAP_CHECK).
+ *
+ * nloptr_check_gradient compares grad, the gradient of f at x where f equals
+ * fx, with forward differences, using one evaluation of f (without gradient)
+ * per check: num_checks components drawn at random (all if 0), or, if
+ * directional is not 0, num_checks random directions with entries +1 or -1.
+ * Checks are split among num_threads threads, thread t calling f with
+ * f_data[t]; f is only called from the calling thread if num_threads is 1.
+ * The work buffers are allocated with malloc, so f must not raise R errors.
+ *
+ * errors, if not NULL, receives the difference between grad and its
+ * approximation for each of the n components (NaN if not checked; estimated
+ * from the directions with directional checks), and max_error the largest
+ * relative error (absolute for derivatives smaller than 1). Returns the number
+ * of checks with an error above tol, or -1 if memory or threads could not be
+ * allocated.
+ */
+
+static inline int nloptr_check_gradient(nlopt_func f, void *const *f_data, unsigned num_threads, unsigned n, const double *x, double fx, const double *grad, unsigned num_checks, int directional, unsigned long seed, double tol, double *errors, double *max_error)
+{
+    return nloptr_api_table()->nloptr_check_gradient(f, f_data, num_threads, n, x, fx, grad, num_checks, directional, seed, tol, errors, max_error);
+}
+
+/*
+ * Sobol low-discrepancy sequences (NLOPTR_CAP_SOBOL), in up to 1111
+ * dimensions, as used by NLOPT_GD_MLSL_LDS.
+ *
+ * nloptr_sobol writes points skip + 1, ..., skip + num_points of the sequence
+ * in dim dimensions, scaled to [lb, ub], into the columns of the dim x
+ * num_points matrix X. Any point can be reached directly, so that workers
+ * given disjoint ranges of skip generate disjoint parts of the sequence.
+ * Returns 0, or -1 if dim is out of range or skip + num_points exceeds
+ * 2^32 - 1.
+ *
+ * nloptr_sobol_screen evaluates f (without gradient) at the same points and
+ * keeps the k >= 1 points with the lowest values, sorted by increasing value,
+ * in the columns of the dim x k matrix best_x and in best_f, e.g. as starting
+ * points. Returns the number of points kept, or -1 on invalid arguments.
+ */
+
+static inline int nloptr_sobol(unsigned dim, unsigned long skip, size_t num_points, const double *lb, const double *ub, double *X)
+{
+    return nloptr_api_table()->nloptr_sobol(dim, skip, num_points, lb, ub, X);
+}
+
+static inline int nloptr_sobol_screen(nlopt_func f, void *f_data, unsigned dim, const double *lb, const double *ub, unsigned long skip, size_t num_points, unsigned k, double *best_x, double *best_f)
+{
+    return nloptr_api_table()->nloptr_sobol_screen(f, f_data, dim, lb, ub, skip, num_points, k, best_x, best_f);
 }
 
 #endif /* __NLOPTRAPI_H__ */
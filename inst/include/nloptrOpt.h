@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   nloptrOpt.h
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file provides a header-only C++ interface to the C API of nloptrAPI.h.
+ * nloptr::Opt owns an nlopt_opt, is movable but not copyable, and takes
+ * objective functions and constraints as functors or lambdas:
+ *
+ *   nloptr::Opt opt(NLOPT_LD_LBFGS, n);
+ *   opt.set_min_objective(
+ *       [](nloptr::span<const double> x, nloptr::span<double> grad) {
+ *         ...
+ *       });
+ *   double f;
+ *   nlopt_result status = opt.optimize(x, f);
+ *
+ * The callback passed to NLopt is a function template instantiated for the
+ * type of each functor, which calls it directly: the body of the functor is
+ * inlined in the callback, without an indirect call through std::function.
+ * grad is empty when NLopt does not need the gradient.
+ *
+ * Functors are copied (or moved) into the Opt object. An exception thrown by a
+ * functor stops the optimization and is rethrown by optimize().
+ *
+ * The header only depends on the C++11 standard library.
+ */
+
+#ifndef __NLOPTROPT_H__
+#define __NLOPTROPT_H__
+
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "nloptrAPI.h"
+
+namespace nloptr {
+
+// Non-owning view of a contiguous array, in the manner of C++20 std::span.
+template <class T> class span {
+public:
+  span() : data_(nullptr), size_(0) {}
+  span(T *data, std::size_t size) : data_(data), size_(size) {}
+  template <class C>
+  span(C &c) : data_(c.data()), size_(c.size()) {}
+
+  T *data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T &operator[](std::size_t i) const { return data_[i]; }
+  T *begin() const { return data_; }
+  T *end() const { return data_ + size_; }
+
+private:
+  T *data_;
+  std::size_t size_;
+};
+
+class Opt {
+public:
+  Opt(nlopt_algorithm algorithm, unsigned n) : state_(new State()) {
+    state_->opt = nlopt_create(algorithm, n);
+    if (!state_->opt) {
+      throw std::bad_alloc();
+    }
+  }
+
+  Opt(const Opt &) = delete;
+  Opt &operator=(const Opt &) = delete;
+  Opt(Opt &&other) noexcept = default;
+  Opt &operator=(Opt &&other) noexcept = default;
+
+  // Underlying handle, still owned by this object.
+  nlopt_opt get() const { return state_ ? state_->opt : nullptr; }
+
+  unsigned dimension() const { return nlopt_get_dimension(get()); }
+  nlopt_algorithm algorithm() const { return nlopt_get_algorithm(get()); }
+
+  // Objective function: f(span<const double> x, span<double> grad) -> double.
+  template <class F> nlopt_result set_min_objective(F f) {
+    return nlopt_set_min_objective(get(), &objective<F>, hold(std::move(f)));
+  }
+  template <class F> nlopt_result set_max_objective(F f) {
+    return nlopt_set_max_objective(get(), &objective<F>, hold(std::move(f)));
+  }
+
+  // Scalar constraints, with the same signature as objective functions.
+  template <class F>
+  nlopt_result add_inequality_constraint(F f, double tol = 0) {
+    return nlopt_add_inequality_constraint(get(), &objective<F>,
+                                           hold(std::move(f)), tol);
+  }
+  template <class F> nlopt_result add_equality_constraint(F f, double tol = 0) {
+    return nlopt_add_equality_constraint(get(), &objective<F>,
+                                         hold(std::move(f)), tol);
+  }
+
+  // m constraints: f(span<double> result, span<const double> x,
+  // span<double> grad), grad being the m by n Jacobian stored by rows; tol is
+  // NULL or of length m.
+  template <class F>
+  nlopt_result add_inequality_mconstraint(unsigned m, F f,
+                                          const double *tol = nullptr) {
+    return nlopt_add_inequality_mconstraint(get(), m, &mconstraint<F>,
+                                            hold(std::move(f)), tol);
+  }
+  template <class F>
+  nlopt_result add_equality_mconstraint(unsigned m, F f,
+                                        const double *tol = nullptr) {
+    return nlopt_add_equality_mconstraint(get(), m, &mconstraint<F>,
+                                          hold(std::move(f)), tol);
+  }
+
+  nlopt_result remove_inequality_constraints() {
+    return nlopt_remove_inequality_constraints(get());
+  }
+  nlopt_result remove_equality_constraints() {
+    return nlopt_remove_equality_constraints(get());
+  }
+
+  nlopt_result set_lower_bounds(span<const double> lb) {
+    return nlopt_set_lower_bounds(get(), lb.data());
+  }
+  nlopt_result set_lower_bounds(double lb) {
+    return nlopt_set_lower_bounds1(get(), lb);
+  }
+  nlopt_result set_upper_bounds(span<const double> ub) {
+    return nlopt_set_upper_bounds(get(), ub.data());
+  }
+  nlopt_result set_upper_bounds(double ub) {
+    return nlopt_set_upper_bounds1(get(), ub);
+  }
+
+  nlopt_result set_stopval(double stopval) {
+    return nlopt_set_stopval(get(), stopval);
+  }
+  nlopt_result set_ftol_rel(double tol) { return nlopt_set_ftol_rel(get(), tol); }
+  nlopt_result set_ftol_abs(double tol) { return nlopt_set_ftol_abs(get(), tol); }
+  nlopt_result set_xtol_rel(double tol) { return nlopt_set_xtol_rel(get(), tol); }
+  nlopt_result set_xtol_abs(span<const double> tol) {
+    return nlopt_set_xtol_abs(get(), tol.data());
+  }
+  nlopt_result set_xtol_abs(double tol) {
+    return nlopt_set_xtol_abs1(get(), tol);
+  }
+  nlopt_result set_maxeval(int maxeval) {
+    return nlopt_set_maxeval(get(), maxeval);
+  }
+  nlopt_result set_maxtime(double maxtime) {
+    return nlopt_set_maxtime(get(), maxtime);
+  }
+  nlopt_result set_population(unsigned pop) {
+    return nlopt_set_population(get(), pop);
+  }
+  nlopt_result set_vector_storage(unsigned dim) {
+    return nlopt_set_vector_storage(get(), dim);
+  }
+  nlopt_result set_initial_step(span<const double> dx) {
+    return nlopt_set_initial_step(get(), dx.data());
+  }
+  nlopt_result set_initial_step(double dx) {
+    return nlopt_set_initial_step1(get(), dx);
+  }
+
+  // NLopt copies the local optimizer, which can be destroyed afterwards; its
+  // objective function is not used.
+  nlopt_result set_local_optimizer(const Opt &local) {
+    return nlopt_set_local_optimizer(get(), local.get());
+  }
+
+  nlopt_result force_stop() { return nlopt_force_stop(get()); }
+
+  // Minimize (or maximize) starting from x, of length dimension(), which is
+  // overwritten by the solution; f is set to the objective value there.
+  nlopt_result optimize(span<double> x, double &f) {
+    state_->error = nullptr;
+    nlopt_result status = nlopt_optimize(get(), x.data(), &f);
+    if (state_->error) {
+      std::exception_ptr error = state_->error;
+      state_->error = nullptr;
+      std::rethrow_exception(error);
+    }
+    return status;
+  }
+
+private:
+  struct Base {
+    virtual ~Base() {}
+  };
+
+  struct State {
+    nlopt_opt opt = nullptr;
+    std::exception_ptr error;
+    std::vector<std::unique_ptr<Base>> functors;
+
+    ~State() {
+      if (opt) {
+        nlopt_destroy(opt);
+      }
+    }
+  };
+
+  // Functor and the state of its Opt, whose address does not change when the
+  // Opt is moved.
+  template <class F> struct Holder : Base {
+    Holder(F &&f, State *state) : f(std::move(f)), state(state) {}
+    F f;
+    State *state;
+  };
+
+  template <class F> void *hold(F &&f) {
+    Holder<F> *holder = new Holder<F>(std::move(f), state_.get());
+    state_->functors.emplace_back(holder);
+    return holder;
+  }
+
+  template <class F>
+  static double objective(unsigned n, const double *x, double *grad,
+                          void *data) {
+    Holder<F> *holder = static_cast<Holder<F> *>(data);
+    try {
+      return holder->f(span<const double>(x, n),
+                       span<double>(grad, grad ? n : 0));
+    } catch (...) {
+      holder->state->error = std::current_exception();
+      nlopt_force_stop(holder->state->opt);
+      return HUGE_VAL;
+    }
+  }
+
+  template <class F>
+  static void mconstraint(unsigned m, double *result, unsigned n,
+                          const double *x, double *grad, void *data) {
+    Holder<F> *holder = static_cast<Holder<F> *>(data);
+    try {
+      holder->f(span<double>(result, m), span<const double>(x, n),
+                span<double>(grad, grad ? (std::size_t)m * n : 0));
+    } catch (...) {
+      holder->state->error = std::current_exception();
+      nlopt_force_stop(holder->state->opt);
+    }
+  }
+
+  std::unique_ptr<State> state_;
+};
+
+} // namespace nloptr
+
+#endif /* __NLOPTROPT_H__ */
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   nloptrTable.h
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the table of the C functions exported by nloptr to other
+ * R packages. The table is registered once as the C-callable nloptr_get_api
+ * and is shared by nloptr (src/init_nloptr.c) and nloptrAPI.h.
+ *
+ * The table is versioned: new entries are only ever appended, along with an
+ * increment of NLOPTR_API_VERSION and a new capability flag, so that callers
+ * built against a newer header can check that the installed nloptr provides
+ * an entry point before using it:
+ *
+ *   const nloptr_api *api = nloptr_api_table();
+ *   if (api->capabilities & NLOPTR_CAP_ASYNC) ...
+ */
+
+#ifndef __NLOPTRTABLE_H__
+#define __NLOPTRTABLE_H__
+
+#include <stddef.h>
+
+#include "nlopt.h"
+
+#define NLOPTR_API_VERSION 3
+
+// Capability flags.
+#define NLOPTR_CAP_ASYNC (1UL << 0) // nloptr_async_* entries
+#define NLOPTR_CAP_CHECK (1UL << 1) // nloptr_check_gradient
+#define NLOPTR_CAP_SOBOL (1UL << 2) // nloptr_sobol, nloptr_sobol_screen
+
+struct nloptr_async_s;
+
+typedef struct nloptr_api_s {
+  int version;                // NLOPTR_API_VERSION of the installed nloptr
+  unsigned long capabilities; // NLOPTR_CAP_* flags
+  size_t size;                // sizeof(nloptr_api) in the installed nloptr
+
+  // NLopt API.
+  const char *(*nlopt_algorithm_name)(nlopt_algorithm);
+  void (*nlopt_srand)(unsigned long);
+  void (*nlopt_srand_time)(void);
+  void (*nlopt_version)(int *, int *, int *);
+  nlopt_opt (*nlopt_create)(nlopt_algorithm, unsigned);
+  void (*nlopt_destroy)(nlopt_opt);
+  nlopt_opt (*nlopt_copy)(const nlopt_opt);
+  nlopt_result (*nlopt_optimize)(nlopt_opt, double *, double *);
+  nlopt_result (*nlopt_set_min_objective)(nlopt_opt, nlopt_func, void *);
+  nlopt_result (*nlopt_set_max_objective)(nlopt_opt, nlopt_func, void *);
+  nlopt_result (*nlopt_set_precond_min_objective)(nlopt_opt, nlopt_func,
+      nlopt_precond, void *);
+  nlopt_result (*nlopt_set_precond_max_objective)(nlopt_opt, nlopt_func,
+      nlopt_precond, void *);
+  nlopt_algorithm (*nlopt_get_algorithm)(const nlopt_opt);
+  unsigned (*nlopt_get_dimension)(const nlopt_opt);
+  nlopt_result (*nlopt_set_lower_bounds)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_set_lower_bounds1)(nlopt_opt, double);
+  nlopt_result (*nlopt_get_lower_bounds)(const nlopt_opt, double *);
+  nlopt_result (*nlopt_set_upper_bounds)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_set_upper_bounds1)(nlopt_opt, double);
+  nlopt_result (*nlopt_get_upper_bounds)(const nlopt_opt, double *);
+  nlopt_result (*nlopt_remove_inequality_constraints)(nlopt_opt);
+  nlopt_result (*nlopt_add_inequality_constraint)(nlopt_opt, nlopt_func, void *,
+      double);
+  nlopt_result (*nlopt_add_precond_inequality_constraint)(nlopt_opt, nlopt_func,
+      nlopt_precond, void *, double);
+  nlopt_result (*nlopt_add_inequality_mconstraint)(nlopt_opt, unsigned,
+      nlopt_mfunc, void *, const double *);
+  nlopt_result (*nlopt_remove_equality_constraints)(nlopt_opt);
+  nlopt_result (*nlopt_add_equality_constraint)(nlopt_opt, nlopt_func, void *,
+      double);
+  nlopt_result (*nlopt_add_precond_equality_constraint)(nlopt_opt, nlopt_func,
+      nlopt_precond, void *, double);
+  nlopt_result (*nlopt_add_equality_mconstraint)(nlopt_opt, unsigned,
+      nlopt_mfunc, void *, const double *);
+  nlopt_result (*nlopt_set_stopval)(nlopt_opt, double);
+  double (*nlopt_get_stopval)(const nlopt_opt);
+  nlopt_result (*nlopt_set_ftol_rel)(nlopt_opt, double);
+  double (*nlopt_get_ftol_rel)(const nlopt_opt);
+  nlopt_result (*nlopt_set_ftol_abs)(nlopt_opt, double);
+  double (*nlopt_get_ftol_abs)(const nlopt_opt);
+  nlopt_result (*nlopt_set_xtol_rel)(nlopt_opt, double);
+  double (*nlopt_get_xtol_rel)(const nlopt_opt);
+  nlopt_result (*nlopt_set_xtol_abs1)(nlopt_opt, double);
+  nlopt_result (*nlopt_set_xtol_abs)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_get_xtol_abs)(nlopt_opt, double *);
+  nlopt_result (*nlopt_set_x_weights1)(nlopt_opt, double);
+  nlopt_result (*nlopt_set_x_weights)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_get_x_weights)(nlopt_opt, double *);
+  nlopt_result (*nlopt_set_maxeval)(nlopt_opt, int);
+  int (*nlopt_get_maxeval)(const nlopt_opt);
+  nlopt_result (*nlopt_set_maxtime)(nlopt_opt, double);
+  double (*nlopt_get_maxtime)(nlopt_opt);
+  nlopt_result (*nlopt_force_stop)(nlopt_opt);
+  nlopt_result (*nlopt_set_force_stop)(nlopt_opt, int);
+  int (*nlopt_get_force_stop)(const nlopt_opt);
+  nlopt_result (*nlopt_set_local_optimizer)(nlopt_opt, const nlopt_opt);
+  nlopt_result (*nlopt_set_population)(nlopt_opt, unsigned);
+  unsigned (*nlopt_get_population)(const nlopt_opt);
+  nlopt_result (*nlopt_set_vector_storage)(nlopt_opt, unsigned);
+  unsigned (*nlopt_get_vector_storage)(const nlopt_opt);
+  nlopt_result (*nlopt_set_default_initial_step)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_set_initial_step)(nlopt_opt, const double *);
+  nlopt_result (*nlopt_set_initial_step1)(nlopt_opt, double);
+  nlopt_result (*nlopt_get_initial_step)(const nlopt_opt, const double *,
+      double *);
+
+  // Asynchronous optimization, see nloptrAPI.h (NLOPTR_CAP_ASYNC).
+  struct nloptr_async_s *(*nloptr_async_start)(nlopt_opt, nlopt_func, void *,
+      const double *);
+  int (*nloptr_async_poll)(struct nloptr_async_s *, double *, double *,
+      unsigned long *);
+  void (*nloptr_async_cancel)(struct nloptr_async_s *);
+  nlopt_result (*nloptr_async_collect)(struct nloptr_async_s *, double *,
+      double *);
+
+  // Sampled derivative checker, see nloptrAPI.h (NLOPTR_CAP_CHECK).
+  int (*nloptr_check_gradient)(nlopt_func, void *const *, unsigned, unsigned,
+      const double *, double, const double *, unsigned, int, unsigned long,
+      double, double *, double *);
+
+  // Sobol sequences, see nloptrAPI.h (NLOPTR_CAP_SOBOL).
+  int (*nloptr_sobol)(unsigned, unsigned long, size_t, const double *,
+      const double *, double *);
+  int (*nloptr_sobol_screen)(nlopt_func, void *, unsigned, const double *,
+      const double *, unsigned long, size_t, unsigned, double *, double *);
+} nloptr_api;
+
+#endif /* __NLOPTRTABLE_H__ */
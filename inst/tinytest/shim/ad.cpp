@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * File:   ad.cpp
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * Test shim of test-ad.R: gradients and Jacobians of C++ functors through
+ * nloptrAD.h, as another package would compute them.
+ */
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+#include <nloptrAD.h>
+
+// Objective function mixing the operators and elementary functions of the
+// duals, with constants combined with dual values.
+struct Objective {
+  template <class T> T operator()(unsigned n, const T *x) const {
+    using std::atan2;
+    using std::exp;
+    using std::hypot;
+    using std::log1p;
+    using std::pow;
+    using std::sin;
+    T f = 0;
+    for (unsigned i = 0; i < n; i++) {
+      f += exp(0.1 * x[i]) * sin(x[i]) + log1p(x[i] * x[i]);
+    }
+    T two = 2.0;
+    f += pow(x[0], 3.0) / (1 + x[1] * x[1]) + atan2(x[0], two) +
+         hypot(x[n - 1], two);
+    f -= x[1] / (x[2] + 3);
+    return f;
+  }
+};
+
+// Constraints: squared norm, product of the first and last controls, and a
+// constant.
+struct Constraints {
+  template <class T>
+  void operator()(unsigned m, T *result, unsigned n, const T *x) const {
+    T s = 0;
+    for (unsigned i = 0; i < n; i++) {
+      s += x[i] * x[i];
+    }
+    result[0] = s;
+    result[1] = x[0] * x[n - 1];
+    for (unsigned i = 2; i < m; i++) {
+      result[i] = T(5.0);
+    }
+  }
+};
+
+template <int N> static double objective(unsigned n, const double *x,
+                                         double *grad) {
+  Objective f;
+  return nloptr::ad::objective<Objective, N>(n, x, grad, &f);
+}
+
+template <int N> static void constraints(unsigned m, double *result,
+                                         unsigned n, const double *x,
+                                         double *jac) {
+  Constraints f;
+  nloptr::ad::mconstraint<Constraints, N>(m, result, n, x, jac, &f);
+}
+
+extern "C" {
+
+// Value and gradient of the objective function at x, with duals of width 1,
+// 4 or Dynamic (0).
+SEXP shim_ad_gradient(SEXP R_x, SEXP R_width) {
+  unsigned n = (unsigned)Rf_length(R_x);
+  const double *x = REAL(R_x);
+  SEXP R_grad = PROTECT(Rf_allocVector(REALSXP, n));
+  double value;
+  switch (Rf_asInteger(R_width)) {
+  case 0:
+    value = objective<nloptr::ad::Dynamic>(n, x, REAL(R_grad));
+    break;
+  case 1:
+    value = objective<1>(n, x, REAL(R_grad));
+    break;
+  case 4:
+    value = objective<4>(n, x, REAL(R_grad));
+    break;
+  default:
+    Rf_error("unsupported width");
+  }
+  Rf_setAttrib(R_grad, Rf_install("value"), Rf_ScalarReal(value));
+  UNPROTECT(1);
+  return R_grad;
+}
+
+// m constraints at x and their Jacobian, as an m by n matrix.
+SEXP shim_ad_jacobian(SEXP R_x, SEXP R_m, SEXP R_width) {
+  unsigned n = (unsigned)Rf_length(R_x);
+  unsigned m = (unsigned)Rf_asInteger(R_m);
+  const double *x = REAL(R_x);
+  double *result = (double *)R_alloc(m, sizeof(double));
+  double *jac = (double *)R_alloc((size_t)m * n, sizeof(double));
+  switch (Rf_asInteger(R_width)) {
+  case 0:
+    constraints<nloptr::ad::Dynamic>(m, result, n, x, jac);
+    break;
+  case 1:
+    constraints<1>(m, result, n, x, jac);
+    break;
+  case 4:
+    constraints<4>(m, result, n, x, jac);
+    break;
+  default:
+    Rf_error("unsupported width");
+  }
+
+  // NLopt stores the Jacobian by rows, R by columns.
+  SEXP R_jac = PROTECT(Rf_allocMatrix(REALSXP, m, n));
+  for (unsigned i = 0; i < m; i++) {
+    for (unsigned j = 0; j < n; j++) {
+      REAL(R_jac)[i + (size_t)j * m] = jac[(size_t)i * n + j];
+    }
+  }
+  SEXP R_result = PROTECT(Rf_allocVector(REALSXP, m));
+  for (unsigned i = 0; i < m; i++) {
+    REAL(R_result)[i] = result[i];
+  }
+  Rf_setAttrib(R_jac, Rf_install("value"), R_result);
+  UNPROTECT(2);
+  return R_jac;
+}
+
+} // extern "C"
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * File:   api.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * Test shim of test-api.R: resolves the versioned table of nloptrTable.h
+ * through nloptrAPI.h and calls NLopt through it, as another package would.
+ */
+
+#include <nloptrAPI.h>
+
+// Shifted sphere, centered at (1, -2).
+static double sphere(unsigned n, const double *x, double *grad, void *data) {
+  static const double center[2] = {1, -2};
+  (void)data;
+  double f = 0;
+  for (unsigned i = 0; i < n; i++) {
+    f += (x[i] - center[i]) * (x[i] - center[i]);
+    if (grad) {
+      grad[i] = 2 * (x[i] - center[i]);
+    }
+  }
+  return f;
+}
+
+/*
+ * Version, capabilities and size of the installed table next to those of the
+ * header, version of NLopt, and the result of minimizing the sphere with
+ * L-BFGS through the wrappers of nloptrAPI.h.
+ */
+SEXP shim_api_table(void) {
+  const nloptr_api *api = nloptr_api_table();
+
+  int major, minor, bugfix;
+  nlopt_version(&major, &minor, &bugfix);
+
+  double x[2] = {0, 0}, f;
+  nlopt_opt opt = nlopt_create(NLOPT_LD_LBFGS, 2);
+  nlopt_set_min_objective(opt, sphere, NULL);
+  nlopt_set_xtol_rel(opt, 1e-10);
+  nlopt_result status = nlopt_optimize(opt, x, &f);
+  const char *algorithm = nlopt_algorithm_name(nlopt_get_algorithm(opt));
+  nlopt_destroy(opt);
+
+  const char *names[] = {"version", "header_version", "capabilities",
+                         "size", "header_size", "cached", "nlopt_version",
+                         "status", "solution", "algorithm", ""};
+  SEXP R_res = PROTECT(mkNamed(VECSXP, names));
+  SET_VECTOR_ELT(R_res, 0, ScalarInteger(api->version));
+  SET_VECTOR_ELT(R_res, 1, ScalarInteger(NLOPTR_API_VERSION));
+  SET_VECTOR_ELT(R_res, 2, ScalarReal((double)api->capabilities));
+  SET_VECTOR_ELT(R_res, 3, ScalarReal((double)api->size));
+  SET_VECTOR_ELT(R_res, 4, ScalarReal((double)sizeof(nloptr_api)));
+  SET_VECTOR_ELT(R_res, 5, ScalarLogical(nloptr_api_table() == api));
+  SEXP R_version = allocVector(INTSXP, 3);
+  SET_VECTOR_ELT(R_res, 6, R_version);
+  INTEGER(R_version)[0] = major;
+  INTEGER(R_version)[1] = minor;
+  INTEGER(R_version)[2] = bugfix;
+  SET_VECTOR_ELT(R_res, 7, ScalarInteger(status));
+  SEXP R_x = allocVector(REALSXP, 2);
+  SET_VECTOR_ELT(R_res, 8, R_x);
+  REAL(R_x)[0] = x[0];
+  REAL(R_x)[1] = x[1];
+  SET_VECTOR_ELT(R_res, 9, mkString(algorithm));
+  UNPROTECT(1);
+  return R_res;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * File:   async.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * Test shim of test-async.R: runs optimizations on a background thread
+ * through nloptrAPI.h, as another package would.
+ */
+
+#include <string.h>
+
+#include <nloptrAPI.h>
+
+// Shifted sphere, centered at data.
+static double sphere(unsigned n, const double *x, double *grad, void *data) {
+  const double *center = (const double *)data;
+  double f = 0;
+  for (unsigned i = 0; i < n; i++) {
+    f += (x[i] - center[i]) * (x[i] - center[i]);
+    if (grad) {
+      grad[i] = 2 * (x[i] - center[i]);
+    }
+  }
+  return f;
+}
+
+// Same, with some work to keep the optimization running while it is polled.
+static double slow_sphere(unsigned n, const double *x, double *grad,
+                          void *data) {
+  volatile double s = 0;
+  for (int k = 0; k < 100000; k++) {
+    s += 1e-9 * k;
+  }
+  return sphere(n, x, grad, data) + 0 * s;
+}
+
+/*
+ * Minimize the sphere centered at (1, 2, ..., n) from x0 with Nelder-Mead on
+ * a background thread, polling until the end, and cancelling after 5
+ * evaluations if cancel is TRUE. Then run nlopt_optimize on the caller's opt,
+ * whose objective must have been left unset.
+ */
+SEXP shim_async_run(SEXP R_x0, SEXP R_cancel) {
+  unsigned n = (unsigned)length(R_x0);
+  int cancel = asLogical(R_cancel) == TRUE;
+  double center[n], x[n], x_best[n];
+  for (unsigned i = 0; i < n; i++) {
+    center[i] = i + 1;
+  }
+
+  nlopt_opt opt = nlopt_create(NLOPT_LN_NELDERMEAD, n);
+  nlopt_set_xtol_rel(opt, cancel ? 0 : 1e-10);
+  nloptr_async h = nloptr_async_start(opt, cancel ? slow_sphere : sphere,
+                                      center, REAL(R_x0));
+  if (!h) {
+    nlopt_destroy(opt);
+    error("nloptr_async_start failed");
+  }
+
+  double f_best = HUGE_VAL;
+  unsigned long num_evals = 0;
+  int cancelled = 0;
+  while (!nloptr_async_poll(h, &f_best, x_best, &num_evals)) {
+    if (cancel && !cancelled && num_evals >= 5) {
+      nloptr_async_cancel(h);
+      cancelled = 1;
+    }
+  }
+  double opt_f;
+  nlopt_result status = nloptr_async_collect(h, x, &opt_f);
+
+  double y[n], f_y;
+  memcpy(y, REAL(R_x0), n * sizeof(double));
+  nlopt_result status_opt = nlopt_optimize(opt, y, &f_y);
+  nlopt_destroy(opt);
+
+  const char *names[] = {"status", "solution", "objective", "f_best",
+                         "num_evals", "status_opt", ""};
+  SEXP R_res = PROTECT(mkNamed(VECSXP, names));
+  SEXP R_x = allocVector(REALSXP, n);
+  SET_VECTOR_ELT(R_res, 1, R_x);
+  memcpy(REAL(R_x), x, n * sizeof(double));
+  SET_VECTOR_ELT(R_res, 0, ScalarInteger(status));
+  SET_VECTOR_ELT(R_res, 2, ScalarReal(opt_f));
+  SET_VECTOR_ELT(R_res, 3, ScalarReal(f_best));
+  SET_VECTOR_ELT(R_res, 4, ScalarReal((double)num_evals));
+  SET_VECTOR_ELT(R_res, 5, ScalarInteger(status_opt));
+  UNPROTECT(1);
+  return R_res;
+}
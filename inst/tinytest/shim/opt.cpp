@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * File:   opt.cpp
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * Test shim of test-api.R: runs an optimization through the C++ interface of
+ * nloptrOpt.h, as another package would.
+ */
+
+#include <stdexcept>
+
+#include <nloptrOpt.h>
+
+/*
+ * Minimize the sphere centered at (1, -2) subject to x[0] + x[1] >= 0 with
+ * SLSQP, whose solution is (1.5, -1.5). If fail is TRUE, the objective
+ * function throws on its fourth call, and the message of the exception
+ * rethrown by optimize() is returned as error.
+ */
+extern "C" SEXP shim_opt_solve(SEXP R_fail) {
+  bool fail = Rf_asLogical(R_fail) == TRUE;
+  int calls = 0;
+
+  nloptr::Opt opt(NLOPT_LD_SLSQP, 2);
+  opt.set_min_objective([&calls, fail](nloptr::span<const double> x,
+                                       nloptr::span<double> grad) {
+    if (fail && ++calls > 3) {
+      throw std::runtime_error("objective failed");
+    }
+    if (!grad.empty()) {
+      grad[0] = 2 * (x[0] - 1);
+      grad[1] = 2 * (x[1] + 2);
+    }
+    return (x[0] - 1) * (x[0] - 1) + (x[1] + 2) * (x[1] + 2);
+  });
+  opt.add_inequality_constraint(
+      [](nloptr::span<const double> x, nloptr::span<double> grad) {
+        if (!grad.empty()) {
+          grad[0] = -1;
+          grad[1] = -1;
+        }
+        return -x[0] - x[1];
+      },
+      1e-10);
+  opt.set_xtol_rel(1e-10);
+
+  std::vector<double> x = {0, 0};
+  double f = HUGE_VAL;
+  nlopt_result status = NLOPT_FAILURE;
+  const char *error = "";
+  try {
+    status = opt.optimize(x, f);
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+
+  const char *names[] = {"status", "solution", "objective", "error", ""};
+  SEXP R_res = PROTECT(Rf_mkNamed(VECSXP, names));
+  SEXP R_x = Rf_allocVector(REALSXP, 2);
+  SET_VECTOR_ELT(R_res, 1, R_x);
+  REAL(R_x)[0] = x[0];
+  REAL(R_x)[1] = x[1];
+  SET_VECTOR_ELT(R_res, 0, Rf_ScalarInteger(status));
+  SET_VECTOR_ELT(R_res, 2, Rf_ScalarReal(f));
+  SET_VECTOR_ELT(R_res, 3, Rf_mkString(error));
+  UNPROTECT(1);
+  return R_res;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   async.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines functions to run an optimization with a native objective
+ * on a background thread, to poll its progress and to cancel it. They are
+ * registered in init_nloptr.c for use by external packages.
+ */
+
+#include "async.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct nloptr_async_s {
+  nlopt_opt opt;
+  nlopt_func f;
+  void *f_data;
+  unsigned n;
+  double *x;     // starting point, then solution
+  double opt_f;  // objective value at the solution
+  nlopt_result status;
+  pthread_t thread;
+
+  // Fields below are shared between threads and guarded by lock.
+  pthread_mutex_t lock;
+  double f_best;
+  double *x_best;
+  unsigned long num_evals;
+  int cancel;
+  int done;
+};
+
+static double async_objective(unsigned n, const double *x, double *grad,
+                              void *data) {
+  nloptr_async h = (nloptr_async)data;
+  double f = h->f(n, x, grad, h->f_data);
+
+  pthread_mutex_lock(&h->lock);
+  h->num_evals++;
+  if (f < h->f_best) {
+    h->f_best = f;
+    memcpy(h->x_best, x, n * sizeof(double));
+  }
+  int cancel = h->cancel;
+  pthread_mutex_unlock(&h->lock);
+
+  // Subsidiary optimizers check the force-stop flag of opt as well.
+  if (cancel) {
+    nlopt_force_stop(h->opt);
+  }
+  return f;
+}
+
+static void *async_run(void *data) {
+  nloptr_async h = (nloptr_async)data;
+  h->status = nlopt_optimize(h->opt, h->x, &h->opt_f);
+
+  pthread_mutex_lock(&h->lock);
+  h->done = 1;
+  pthread_mutex_unlock(&h->lock);
+  return NULL;
+}
+
+nloptr_async nloptr_async_start(nlopt_opt opt, nlopt_func f, void *f_data,
+                                const double *x0) {
+  if (!opt || !f || !x0) {
+    return NULL;
+  }
+
+  nloptr_async h = (nloptr_async)calloc(1, sizeof(struct nloptr_async_s));
+  if (!h) {
+    return NULL;
+  }
+  h->f = f;
+  h->f_data = f_data;
+  h->n = nlopt_get_dimension(opt);
+  h->x = (double *)malloc(h->n * sizeof(double));
+  h->x_best = (double *)malloc(h->n * sizeof(double));
+  h->opt_f = HUGE_VAL;
+  h->f_best = HUGE_VAL;
+  if (!h->x || !h->x_best) {
+    free(h->x);
+    free(h->x_best);
+    free(h);
+    return NULL;
+  }
+  memcpy(h->x, x0, h->n * sizeof(double));
+  memcpy(h->x_best, x0, h->n * sizeof(double));
+
+  if (pthread_mutex_init(&h->lock, NULL) != 0) {
+    free(h->x);
+    free(h->x_best);
+    free(h);
+    return NULL;
+  }
+
+  // The optimization runs on a copy of opt, so that the objective of the
+  // caller's opt never points to the handle, even once it is released.
+  h->opt = nlopt_copy(opt);
+  if (!h->opt ||
+      nlopt_set_min_objective(h->opt, async_objective, h) != NLOPT_SUCCESS ||
+      pthread_create(&h->thread, NULL, async_run, h) != 0) {
+    nlopt_destroy(h->opt);
+    pthread_mutex_destroy(&h->lock);
+    free(h->x);
+    free(h->x_best);
+    free(h);
+    return NULL;
+  }
+  return h;
+}
+
+int nloptr_async_poll(nloptr_async h, double *f_best, double *x_best,
+                      unsigned long *num_evals) {
+  pthread_mutex_lock(&h->lock);
+  if (f_best) {
+    *f_best = h->f_best;
+  }
+  if (x_best) {
+    memcpy(x_best, h->x_best, h->n * sizeof(double));
+  }
+  if (num_evals) {
+    *num_evals = h->num_evals;
+  }
+  int done = h->done;
+  pthread_mutex_unlock(&h->lock);
+  return done;
+}
+
+void nloptr_async_cancel(nloptr_async h) {
+  pthread_mutex_lock(&h->lock);
+  h->cancel = 1;
+  pthread_mutex_unlock(&h->lock);
+}
+
+nlopt_result nloptr_async_collect(nloptr_async h, double *x, double *opt_f) {
+  pthread_join(h->thread, NULL);
+
+  nlopt_result status = h->status;
+  if (x) {
+    memcpy(x, h->x, h->n * sizeof(double));
+  }
+  if (opt_f) {
+    *opt_f = h->opt_f;
+  }
+
+  nlopt_destroy(h->opt);
+  pthread_mutex_destroy(&h->lock);
+  free(h->x);
+  free(h->x_best);
+  free(h);
+  return status;
+}
@@ -0,0 +1,53 @@
+#ifndef __ASYNC_H__
+#define __ASYNC_H__
+
+#include <nlopt.h>
+
+// Handle on an optimization running on a background thread.
+typedef struct nloptr_async_s *nloptr_async;
+
+/*
+ * Start minimizing f with the algorithm, bounds, constraints and termination
+ * conditions of opt on a background thread, starting from x0.
+ *
+ * The optimization runs on a copy of opt, whose objective is replaced by f;
+ * opt itself is left unchanged and may be destroyed once this returns. f and
+ * the constraint functions of opt are called from the background thread, so
+ * they must not call the R API. f_data and the data of the constraints must
+ * stay alive until the handle is collected.
+ *
+ * Returns NULL if the thread could not be started.
+ */
+nloptr_async nloptr_async_start(nlopt_opt opt, nlopt_func f, void *f_data,
+                                const double *x0);
+
+/*
+ * Get the progress of the optimization without blocking.
+ *
+ * f_best     : lowest objective value evaluated so far (HUGE_VAL if none)
+ * x_best     : point where f_best was evaluated, of length n; may be NULL
+ * num_evals  : number of objective evaluations so far; may be NULL
+ *
+ * Feasibility of x_best with respect to the constraints is not checked.
+ *
+ * Returns 1 if the optimization is over, 0 if it is still running.
+ */
+int nloptr_async_poll(nloptr_async h, double *f_best, double *x_best,
+                      unsigned long *num_evals);
+
+/*
+ * Ask the optimization to stop. nlopt_force_stop is called from the
+ * background thread after the evaluation in progress, and the optimization
+ * ends with status NLOPT_FORCED_STOP. Does not block.
+ */
+void nloptr_async_cancel(nloptr_async h);
+
+/*
+ * Wait for the end of the optimization, copy the solution to x (of length n)
+ * and its objective value to opt_f, and release the handle.
+ *
+ * Returns the status of nlopt_optimize.
+ */
+nlopt_result nloptr_async_collect(nloptr_async h, double *x, double *opt_f);
+
+#endif /*__ASYNC_H__*/
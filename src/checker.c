@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   checker.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines a derivative checker comparing gradients with forward
+ * differences on a random subset of components or along random directions,
+ * so that large problems are checked with a few evaluations. It is used by
+ * nloptr() during the optimization and registered in init_nloptr.c for use by
+ * external packages.
+ */
+
+#include "checker.h"
+
+#include <R.h>
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Direction k, with entries +1 or -1 drawn from a stream that only depends on
+// the seed and k, so that threads regenerate it instead of storing it.
+static void direction(unsigned long seed, unsigned k, unsigned n, double *d) {
+  uint64_t state = (uint64_t)seed + 0xD1B54A32D192ED03ULL * ((uint64_t)k + 1);
+  uint64_t bits = 0;
+  for (unsigned i = 0; i < n; i++) {
+    if (i % 64 == 0) {
+      bits = splitmix64(&state);
+    }
+    d[i] = (bits & 1) ? 1.0 : -1.0;
+    bits >>= 1;
+  }
+}
+
+typedef struct {
+  nlopt_func f;
+  void *f_data;
+  unsigned n;
+  const double *x;
+  double fx;
+  const unsigned *index; // components checked, NULL for directional checks
+  unsigned num_checks;
+  unsigned long seed;
+  double h;     // step along directions
+  unsigned first, stride; // checks first, first + stride, ...
+  double *fd;   // forward difference of each check
+  double *work; // point and direction, 2 * n
+} check_task;
+
+static void *run_checks(void *data) {
+  check_task *t = (check_task *)data;
+  unsigned n = t->n;
+  double *y = t->work;
+  double *d = t->work + n;
+  memcpy(y, t->x, n * sizeof(double));
+  for (unsigned k = t->first; k < t->num_checks; k += t->stride) {
+    if (t->index) {
+      unsigned i = t->index[k];
+      y[i] = t->x[i] + sqrt(DBL_EPSILON) * fmax(fabs(t->x[i]), 1.0);
+      double h = y[i] - t->x[i];
+      t->fd[k] = (t->f(n, y, NULL, t->f_data) - t->fx) / h;
+      y[i] = t->x[i];
+    } else {
+      direction(t->seed, k, n, d);
+      for (unsigned i = 0; i < n; i++) {
+        y[i] = t->x[i] + t->h * d[i];
+      }
+      t->fd[k] = (t->f(n, y, NULL, t->f_data) - t->fx) / t->h;
+    }
+  }
+  return NULL;
+}
+
+// Work buffers of the checks.
+struct nl_check_buffers_s {
+  double *fd;         // forward differences, num_checks + 1
+  double *work;       // points and directions of the threads, 2 n each
+  check_task *tasks;  // num_threads
+  pthread_t *threads; // num_threads
+  int *started;       // num_threads
+  unsigned *index;    // components checked, n + 1; NULL for directional checks
+};
+
+// Number of checks and of threads actually run.
+static void check_sizes(unsigned n, unsigned *num_threads,
+                        unsigned *num_checks, int *directional) {
+  if (*num_checks == 0) {
+    *directional = 0;
+  }
+  if (!*directional && (*num_checks == 0 || *num_checks > n)) {
+    *num_checks = n;
+  }
+  if (*num_threads > *num_checks) {
+    *num_threads = *num_checks;
+  }
+  if (*num_threads < 1) {
+    *num_threads = 1;
+  }
+}
+
+// Run the checks with the buffers b, sized by check_sizes.
+static int check_gradient(nl_check_buffers *b, nlopt_func f,
+                          void *const *f_data, unsigned num_threads,
+                          unsigned n, const double *x, double fx,
+                          const double *grad, unsigned num_checks,
+                          int directional, unsigned long seed, double tol,
+                          double *errors, double *max_error) {
+  double *fd = b->fd;
+  double *work = b->work;
+  check_task *tasks = b->tasks;
+  unsigned *index = b->index;
+
+  // Components checked: the first num_checks of a random permutation.
+  uint64_t state = seed;
+  if (!directional) {
+    for (unsigned i = 0; i < n; i++) {
+      index[i] = i;
+    }
+    if (num_checks < n) {
+      for (unsigned k = 0; k < num_checks; k++) {
+        unsigned j = k + (unsigned)(splitmix64(&state) % (n - k));
+        unsigned tmp = index[k];
+        index[k] = index[j];
+        index[j] = tmp;
+      }
+    }
+  }
+
+  double x_max = 1.0;
+  for (unsigned i = 0; i < n; i++) {
+    x_max = fmax(x_max, fabs(x[i]));
+  }
+
+  for (unsigned t = 0; t < num_threads; t++) {
+    check_task task = {f,    f_data[t],  n,     x,           fx,
+                       index, num_checks, seed, sqrt(DBL_EPSILON) * x_max,
+                       t,    num_threads, fd,   work + (size_t)t * 2 * n};
+    tasks[t] = task;
+  }
+  for (unsigned t = 1; t < num_threads; t++) {
+    b->started[t] =
+        pthread_create(&b->threads[t], NULL, run_checks, &tasks[t]) == 0;
+  }
+  run_checks(&tasks[0]);
+  for (unsigned t = 1; t < num_threads; t++) {
+    if (b->started[t]) {
+      pthread_join(b->threads[t], NULL);
+    } else {
+      run_checks(&tasks[t]);
+    }
+  }
+
+  // Compare with the analytic derivatives.
+  double *d = work;
+  int num_failed = 0;
+  double max = 0.0;
+  if (errors) {
+    for (unsigned i = 0; i < n; i++) {
+      errors[i] = directional ? 0.0 : NAN;
+    }
+  }
+  for (unsigned k = 0; k < num_checks; k++) {
+    double analytic = 0.0;
+    if (directional) {
+      direction(seed, k, n, d);
+      for (unsigned i = 0; i < n; i++) {
+        analytic += d[i] * grad[i];
+      }
+    } else {
+      analytic = grad[index[k]];
+    }
+    double diff = analytic - fd[k];
+    // Derivatives close to 0, as near a solution, are compared in absolute
+    // terms, since forward differences are only accurate to about sqrt(eps).
+    double relative = fabs(diff) / fmax(fabs(fd[k]), 1.0);
+    if (!(relative <= tol)) {
+      num_failed++;
+    }
+    max = fmax(max, relative);
+
+    // The directions have uncorrelated unit entries, so that averaging the
+    // errors along them weighted by d[i] estimates the error on component i.
+    if (errors) {
+      if (directional) {
+        for (unsigned i = 0; i < n; i++) {
+          errors[i] += d[i] * diff / num_checks;
+        }
+      } else {
+        errors[index[k]] = diff;
+      }
+    }
+  }
+  if (max_error) {
+    *max_error = max;
+  }
+
+  return num_failed;
+}
+
+int nloptr_check_gradient(nlopt_func f, void *const *f_data,
+                          unsigned num_threads, unsigned n, const double *x,
+                          double fx, const double *grad, unsigned num_checks,
+                          int directional, unsigned long seed, double tol,
+                          double *errors, double *max_error) {
+  check_sizes(n, &num_threads, &num_checks, &directional);
+
+  nl_check_buffers b;
+  b.fd = (double *)malloc((num_checks + 1) * sizeof(double));
+  b.work = (double *)malloc((size_t)num_threads * 2 * n * sizeof(double));
+  b.tasks = (check_task *)malloc(num_threads * sizeof(check_task));
+  b.threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+  b.started = (int *)calloc(num_threads, sizeof(int));
+  b.index = NULL;
+  if (!directional) {
+    b.index = (unsigned *)malloc((n + 1) * sizeof(unsigned));
+  }
+  int num_failed = -1;
+  if (b.fd && b.work && b.tasks && b.threads && b.started &&
+      (directional || b.index)) {
+    num_failed = check_gradient(&b, f, f_data, num_threads, n, x, fx, grad,
+                                num_checks, directional, seed, tol, errors,
+                                max_error);
+  }
+
+  free(b.fd);
+  free(b.work);
+  free(b.tasks);
+  free(b.threads);
+  free(b.started);
+  free(b.index);
+  return num_failed;
+}
+
+void nl_check_point(nl_check_state *s, unsigned n, const double *x, double fx,
+                    const double *grad, size_t iteration) {
+  s->num_gradients++;
+  if (s->num_gradients > 1 &&
+      (s->every == 0 || (s->num_gradients - 1) % s->every != 0)) {
+    return;
+  }
+
+  // The buffers are allocated once with R_alloc, and released by R even if f
+  // raises an error.
+  unsigned num_threads = s->num_threads;
+  unsigned num_checks = s->num_checks;
+  int directional = s->directional;
+  check_sizes(n, &num_threads, &num_checks, &directional);
+  if (!s->buffers) {
+    nl_check_buffers *b =
+        (nl_check_buffers *)R_alloc(1, sizeof(nl_check_buffers));
+    b->fd = (double *)R_alloc(num_checks + 1, sizeof(double));
+    b->work = (double *)R_alloc((size_t)num_threads * 2 * n, sizeof(double));
+    b->tasks = (check_task *)R_alloc(num_threads, sizeof(check_task));
+    b->threads = (pthread_t *)R_alloc(num_threads, sizeof(pthread_t));
+    b->started = (int *)R_alloc(num_threads, sizeof(int));
+    b->index = directional ? NULL
+                           : (unsigned *)R_alloc(n + 1, sizeof(unsigned));
+    s->buffers = b;
+  }
+
+  double max_error;
+  int num_failed = check_gradient(
+      s->buffers, s->f, s->f_data, num_threads, n, x, fx, grad, num_checks,
+      directional, s->seed + s->num_points, s->tol, s->errors, &max_error);
+  s->num_points++;
+  s->num_failed += num_failed;
+  if (num_failed > 0 && s->first_failed == 0) {
+    s->first_failed = iteration;
+  }
+  s->max_error = fmax(s->max_error, max_error);
+  for (unsigned i = 0; i < n; i++) {
+    double e = fabs(s->errors[i]);
+    if (!isnan(e) && !(fabs(s->worst[i]) >= e)) {
+      s->worst[i] = e;
+    }
+  }
+}
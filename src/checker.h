@@ -0,0 +1,66 @@
+#ifndef __CHECKER_H__
+#define __CHECKER_H__
+
+#include <nlopt.h>
+
+/*
+ * Compare grad, the gradient of f at x, with forward differences of f, using
+ * one evaluation of f (without gradient) per check besides fx = f(x).
+ *
+ * num_checks   : number of checks; 0 checks all n components
+ * directional  : if 0, check num_checks components drawn at random; otherwise
+ *                check the derivatives along num_checks random directions with
+ *                entries +1 or -1, whatever n is
+ * seed         : seed of the components or directions drawn
+ * tol          : relative error above which a check fails; the error is
+ *                absolute for derivatives smaller than 1 in magnitude
+ * num_threads  : number of threads evaluating f; thread t calls f with
+ *                f_data[t], so that f_data has num_threads elements. f is only
+ *                called from the calling thread if num_threads is 1.
+ * errors       : NULL, or of length n, set to the difference between grad and
+ *                its approximation for each component. Components that are
+ *                not checked are NaN. With directional checks, the differences
+ *                are estimated from the errors along the directions, which
+ *                points at the offending components.
+ * max_error    : NULL, or set to the largest relative error of a check
+ *
+ * Returns the number of failed checks, or -1 if memory or threads could not
+ * be allocated. The work buffers are allocated with malloc, so f must not raise
+ * R errors; nl_check_point allocates them with R_alloc instead.
+ */
+int nloptr_check_gradient(nlopt_func f, void *const *f_data,
+                          unsigned num_threads, unsigned n, const double *x,
+                          double fx, const double *grad, unsigned num_checks,
+                          int directional, unsigned long seed, double tol,
+                          double *errors, double *max_error);
+
+// Work buffers of the checks.
+typedef struct nl_check_buffers_s nl_check_buffers;
+
+// Define structure holding the derivative checks run by nloptr() during an
+// optimization, at every `every`-th evaluation of the gradient.
+typedef struct {
+  nlopt_func f;          // objective function, called without gradient
+  void **f_data;         // data of f, one per thread
+  unsigned num_threads;  // threads evaluating f
+  unsigned num_checks;   // components or directions checked at each point
+  int directional;       // whether directions are checked
+  unsigned long seed;    // seed of the first point, incremented at each point
+  double tol;            // relative error above which a check fails
+  size_t every;          // gradient evaluations between checks, 0 for once
+  size_t num_gradients;  // gradient evaluations so far
+  size_t num_points;     // points checked
+  size_t num_failed;     // failed checks over all points
+  size_t first_failed;   // evaluation with the first failed check, or 0
+  double max_error;      // largest relative error over all points
+  double *errors;        // work, of length n
+  double *worst;         // largest absolute error of each component, or NaN
+  nl_check_buffers *buffers; // allocated with R_alloc at the first check
+} nl_check_state;
+
+// Count a gradient evaluation at x, made at evaluation `iteration`, and check
+// it if it is due. Must be called from the main R thread, within a .Call.
+void nl_check_point(nl_check_state *s, unsigned n, const double *x, double fx,
+                    const double *grad, size_t iteration);
+
+#endif /*__CHECKER_H__*/
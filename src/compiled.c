@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   compiled.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the stack machine evaluating objective functions compiled
+ * from R expressions by nl.compile(), without calling the R interpreter.
+ */
+
+#include "compiled.h"
+#include "parsers.h"
+
+#include <R.h>
+#include <Rmath.h>
+#include <math.h>
+
+#define UNARY(expr)                                                            \
+  {                                                                            \
+    double *a = stack + (size_t)(sp - 1) * B;                                  \
+    for (size_t b = 0; b < B; b++) {                                           \
+      double v = a[b];                                                         \
+      a[b] = (expr);                                                           \
+    }                                                                          \
+  }                                                                            \
+  break
+
+#define BINARY(expr)                                                           \
+  {                                                                            \
+    double *a = stack + (size_t)(sp - 2) * B;                                  \
+    const double *c = a + B;                                                   \
+    for (size_t b = 0; b < B; b++) {                                           \
+      double u = a[b], v = c[b];                                               \
+      a[b] = (expr);                                                           \
+    }                                                                          \
+    sp--;                                                                      \
+  }                                                                            \
+  break
+
+void nl_program_eval(const nl_program *p, unsigned n, const double *X,
+                     size_t B, double *out, double *stack) {
+  int sp = 0;
+  for (size_t i = 0; i < p->num_code; i++) {
+    int op = p->code[2 * i];
+    int arg = p->code[2 * i + 1];
+    switch (op) {
+    case NL_OP_CONST: {
+      double *a = stack + (size_t)sp * B;
+      double value = p->consts[arg];
+      for (size_t b = 0; b < B; b++) {
+        a[b] = value;
+      }
+      sp++;
+      break;
+    }
+    case NL_OP_X: {
+      double *a = stack + (size_t)sp * B;
+      for (size_t b = 0; b < B; b++) {
+        a[b] = X[b * n + arg];
+      }
+      sp++;
+      break;
+    }
+    case NL_OP_ADD:
+      BINARY(u + v);
+    case NL_OP_SUB:
+      BINARY(u - v);
+    case NL_OP_MUL:
+      BINARY(u * v);
+    case NL_OP_DIV:
+      BINARY(u / v);
+    case NL_OP_POW:
+      BINARY(R_pow(u, v));
+    case NL_OP_NEG:
+      UNARY(-v);
+    case NL_OP_EXP:
+      UNARY(exp(v));
+    case NL_OP_LOG:
+      UNARY(log(v));
+    case NL_OP_SQRT:
+      UNARY(sqrt(v));
+    case NL_OP_SIN:
+      UNARY(sin(v));
+    case NL_OP_COS:
+      UNARY(cos(v));
+    case NL_OP_TAN:
+      UNARY(tan(v));
+    case NL_OP_SINH:
+      UNARY(sinh(v));
+    case NL_OP_COSH:
+      UNARY(cosh(v));
+    case NL_OP_ASIN:
+      UNARY(asin(v));
+    case NL_OP_ACOS:
+      UNARY(acos(v));
+    case NL_OP_ATAN:
+      UNARY(atan(v));
+    case NL_OP_PNORM:
+      UNARY(pnorm(v, 0.0, 1.0, 1, 0));
+    case NL_OP_DNORM:
+      UNARY(dnorm(v, 0.0, 1.0, 0));
+    case NL_OP_GAMMA:
+      UNARY(gammafn(v));
+    case NL_OP_LGAMMA:
+      UNARY(lgammafn(v));
+    case NL_OP_DIGAMMA:
+      UNARY(digamma(v));
+    case NL_OP_TRIGAMMA:
+      UNARY(trigamma(v));
+    case NL_OP_PSIGAMMA:
+      UNARY(psigamma(v, arg));
+    }
+  }
+  for (size_t b = 0; b < B; b++) {
+    out[b] = stack[b];
+  }
+}
+
+// Read a program from an R list and check that it is well formed: known
+// opcodes, valid arguments and a stack that never underflows, never exceeds
+// stack_size and ends with a single value.
+static int read_program(nl_program *p, SEXP R_program, unsigned n) {
+  SEXP R_code = getListElement(R_program, "code");
+  SEXP R_consts = getListElement(R_program, "consts");
+  SEXP R_stack_size = getListElement(R_program, "stack_size");
+  if (!isInteger(R_code) || !isReal(R_consts) || length(R_code) % 2 != 0 ||
+      length(R_stack_size) != 1) {
+    return -1;
+  }
+  p->code = INTEGER(R_code);
+  p->num_code = length(R_code) / 2;
+  p->consts = REAL(R_consts);
+  p->stack_size = asInteger(R_stack_size);
+
+  size_t num_consts = length(R_consts);
+  int sp = 0;
+  for (size_t i = 0; i < p->num_code; i++) {
+    int op = p->code[2 * i];
+    int arg = p->code[2 * i + 1];
+    if (op == NL_OP_CONST) {
+      if (arg < 0 || (size_t)arg >= num_consts) {
+        return -1;
+      }
+      sp++;
+    } else if (op == NL_OP_X) {
+      if (arg < 0 || (unsigned)arg >= n) {
+        return -1;
+      }
+      sp++;
+    } else if (op >= NL_OP_ADD && op <= NL_OP_POW) {
+      sp--;
+    } else if (op == NL_OP_PSIGAMMA) {
+      if (arg < 0 || arg > 100) {
+        return -1;
+      }
+    } else if (op < NL_OP_NEG || op > NL_OP_TRIGAMMA) {
+      return -1;
+    }
+    if (sp < 1 || sp > p->stack_size) {
+      return -1;
+    }
+  }
+  return sp == 1 ? 0 : -1;
+}
+
+int nl_program_thread_safe(const nl_program *p) {
+  for (size_t i = 0; i < p->num_code; i++) {
+    int op = p->code[2 * i];
+    if (op >= NL_OP_GAMMA && op <= NL_OP_PSIGAMMA) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int nl_compiled_init(nl_compiled *c, SEXP R_compiled, unsigned n) {
+  c->n = n;
+  if (asInteger(getListElement(R_compiled, "n")) != (int)n ||
+      read_program(&c->objective, getListElement(R_compiled, "objective"),
+                   n) != 0) {
+    return -1;
+  }
+  int stack_size = c->objective.stack_size;
+
+  SEXP R_gradient = getListElement(R_compiled, "gradient");
+  c->gradient = NULL;
+  if (R_gradient != R_NilValue) {
+    if (length(R_gradient) != n) {
+      return -1;
+    }
+    c->gradient = (nl_program *)R_alloc(n, sizeof(nl_program));
+    for (size_t j = 0; j < n; j++) {
+      if (read_program(&c->gradient[j], VECTOR_ELT(R_gradient, j), n) != 0) {
+        return -1;
+      }
+      if (c->gradient[j].stack_size > stack_size) {
+        stack_size = c->gradient[j].stack_size;
+      }
+    }
+  }
+  c->stack = (double *)R_alloc(stack_size, sizeof(double));
+  return 0;
+}
+
+double nl_compiled_objective(nl_compiled *c, const double *x, double *grad) {
+  double f;
+  nl_program_eval(&c->objective, c->n, x, 1, &f, c->stack);
+  if (grad && c->gradient) {
+    for (size_t j = 0; j < c->n; j++) {
+      nl_program_eval(&c->gradient[j], c->n, x, 1, grad + j, c->stack);
+    }
+  }
+  return f;
+}
+
+SEXP NLoptR_Program_Eval(SEXP R_program, SEXP R_X) {
+  if (!isReal(R_X) || !isMatrix(R_X)) {
+    error("X must be a numeric matrix.");
+  }
+  unsigned n = nrows(R_X);
+  size_t B = ncols(R_X);
+  nl_program p;
+  if (read_program(&p, R_program, n) != 0) {
+    error("Malformed program.");
+  }
+  double *stack = (double *)R_alloc((size_t)p.stack_size * B, sizeof(double));
+  SEXP R_out = PROTECT(allocVector(REALSXP, B));
+  if (B > 0) {
+    nl_program_eval(&p, n, REAL(R_X), B, REAL(R_out), stack);
+  }
+  UNPROTECT(1);
+  return R_out;
+}
@@ -0,0 +1,85 @@
+#ifndef __COMPILED_H__
+#define __COMPILED_H__
+
+#include <stddef.h>
+
+#include <Rinternals.h>
+
+// Instructions of the bytecode of compiled expressions. Each instruction is a
+// pair of integers (opcode, argument); only NL_OP_CONST (index of the
+// constant), NL_OP_X (0-based index of the control) and NL_OP_PSIGAMMA (order
+// of the derivative) use the argument.
+// The opcodes must match those used by nl.compile() in R/nl.compile.R.
+enum {
+  NL_OP_CONST = 1,
+  NL_OP_X,
+  NL_OP_ADD,
+  NL_OP_SUB,
+  NL_OP_MUL,
+  NL_OP_DIV,
+  NL_OP_POW,
+  NL_OP_NEG,
+  NL_OP_EXP,
+  NL_OP_LOG,
+  NL_OP_SQRT,
+  NL_OP_SIN,
+  NL_OP_COS,
+  NL_OP_TAN,
+  NL_OP_SINH,
+  NL_OP_COSH,
+  NL_OP_ASIN,
+  NL_OP_ACOS,
+  NL_OP_ATAN,
+  NL_OP_PNORM,
+  NL_OP_DNORM,
+  NL_OP_GAMMA,
+  NL_OP_LGAMMA,
+  NL_OP_DIGAMMA,
+  NL_OP_TRIGAMMA,
+  NL_OP_PSIGAMMA
+};
+
+// Define structure holding a program of the stack machine.
+typedef struct {
+  const int *code;      // instructions, 2 integers each
+  size_t num_code;      // number of instructions
+  const double *consts; // constants
+  int stack_size;       // maximal depth of the stack
+} nl_program;
+
+// Define structure holding a compiled objective function and its gradient.
+typedef struct {
+  unsigned n;           // number of controls
+  nl_program objective; // program of the objective function
+  nl_program *gradient; // programs of the partial derivatives, or NULL
+  double *stack;        // workspace for a single point
+} nl_compiled;
+
+/*
+ * Evaluate the program at B points stored column-wise in X (n x B). Each
+ * instruction is applied to all points before the next one, so that the inner
+ * loops run over contiguous memory. stack must hold stack_size * B doubles.
+ */
+void nl_program_eval(const nl_program *p, unsigned n, const double *X,
+                     size_t B, double *out, double *stack);
+
+/*
+ * Read a compiled objective function from the list built by nl.compile(),
+ * with elements n, objective and gradient. Memory is allocated with R_alloc.
+ * Returns 0 on success, and a negative value if the list is malformed.
+ */
+int nl_compiled_init(nl_compiled *c, SEXP R_compiled, unsigned n);
+
+// Whether the program can be evaluated off the main R thread. The gamma
+// functions of Rmath can raise warnings through R, hence cannot.
+int nl_program_thread_safe(const nl_program *p);
+
+// Evaluate a compiled objective function, and its gradient if grad is not
+// NULL, at x.
+double nl_compiled_objective(nl_compiled *c, const double *x, double *grad);
+
+// .Call entry: evaluate a program, given as a list with elements code, consts
+// and stack_size, at the columns of the matrix X.
+SEXP NLoptR_Program_Eval(SEXP R_program, SEXP R_X);
+
+#endif /*__COMPILED_H__*/
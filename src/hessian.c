@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   hessian.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the estimation of the Hessian at the solution from
+ * differences of gradients, grouping the columns that do not interact
+ * (Curtis, Powell and Reid, 1974), and its inversion into a covariance matrix
+ * with LAPACK.
+ */
+
+#define USE_FC_LEN_T
+
+#include "hessian.h"
+
+#include <R.h>
+#include <R_ext/Lapack.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#ifndef FCONE
+#define FCONE
+#endif
+
+// Number of points at which gradients are requested at once.
+#define HESSIAN_BLOCK 64
+
+int nl_hessian(nl_gradients_func f, void *data, unsigned n, const double *x,
+               const int *groups, unsigned num_groups, const int *pattern,
+               const double *lb, const double *ub, double *H) {
+  if (!groups) {
+    num_groups = n;
+  }
+
+  // Step of each control, backwards where a forward step leaves the bounds.
+  double *step = (double *)R_alloc(n, sizeof(double));
+  for (size_t j = 0; j < n; j++) {
+    double h = sqrt(DBL_EPSILON) * fmax(fabs(x[j]), 1.0);
+    if (ub && x[j] + h > ub[j] && !(lb && x[j] - h < lb[j])) {
+      h = -h;
+    }
+    // Step actually taken, after rounding of x + h.
+    step[j] = (x[j] + h) - x[j];
+  }
+
+  // Gradient at x.
+  double *g0 = (double *)R_alloc(n, sizeof(double));
+  if (f(n, 1, x, g0, data) != 0) {
+    return -1;
+  }
+
+  // Columns of each group, in order.
+  int *start = (int *)R_alloc(num_groups + 1, sizeof(int));
+  int *members = (int *)R_alloc(n, sizeof(int));
+  memset(start, 0, (num_groups + 1) * sizeof(int));
+  for (size_t j = 0; j < n; j++) {
+    start[(groups ? groups[j] : (int)j) + 1]++;
+  }
+  for (size_t g = 0; g < num_groups; g++) {
+    start[g + 1] += start[g];
+  }
+  int *fill = (int *)R_alloc(num_groups, sizeof(int));
+  memcpy(fill, start, num_groups * sizeof(int));
+  for (size_t j = 0; j < n; j++) {
+    members[fill[groups ? groups[j] : (int)j]++] = j;
+  }
+
+  memset(H, 0, (size_t)n * n * sizeof(double));
+  size_t B = num_groups < HESSIAN_BLOCK ? num_groups : HESSIAN_BLOCK;
+  double *X = (double *)R_alloc((size_t)n * B, sizeof(double));
+  double *G = (double *)R_alloc((size_t)n * B, sizeof(double));
+  for (size_t g_first = 0; g_first < num_groups; g_first += B) {
+    size_t b_max = num_groups - g_first < B ? num_groups - g_first : B;
+    for (size_t b = 0; b < b_max; b++) {
+      double *xb = X + b * n;
+      memcpy(xb, x, n * sizeof(double));
+      for (int k = start[g_first + b]; k < start[g_first + b + 1]; k++) {
+        xb[members[k]] += step[members[k]];
+      }
+    }
+    if (f(n, b_max, X, G, data) != 0) {
+      return -1;
+    }
+
+    // Each row of the difference is assigned to the member of the group that
+    // may have a nonzero in this row.
+    for (size_t b = 0; b < b_max; b++) {
+      const double *gb = G + b * n;
+      int first = start[g_first + b], last = start[g_first + b + 1];
+      for (size_t i = 0; i < n; i++) {
+        double diff = gb[i] - g0[i];
+        for (int k = first; k < last; k++) {
+          int j = members[k];
+          if (!pattern || pattern[i + (size_t)j * n]) {
+            H[i + (size_t)j * n] = diff / step[j];
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  for (size_t j = 0; j < n; j++) {
+    for (size_t i = j + 1; i < n; i++) {
+      double h = 0.5 * (H[i + j * n] + H[j + i * n]);
+      H[i + j * n] = h;
+      H[j + i * n] = h;
+    }
+  }
+  return 0;
+}
+
+int nl_covariance(unsigned n, const double *H, double *C) {
+  int N = n, info;
+  memcpy(C, H, (size_t)n * n * sizeof(double));
+  F77_CALL(dpotrf)("L", &N, C, &N, &info FCONE);
+  if (info != 0) {
+    return info;
+  }
+  F77_CALL(dpotri)("L", &N, C, &N, &info FCONE);
+  if (info != 0) {
+    return info;
+  }
+  for (size_t j = 0; j < n; j++) {
+    for (size_t i = j + 1; i < n; i++) {
+      C[j + i * n] = C[i + j * n];
+    }
+  }
+  return 0;
+}
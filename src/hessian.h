@@ -0,0 +1,41 @@
+#ifndef __HESSIAN_H__
+#define __HESSIAN_H__
+
+#include <stddef.h>
+
+// Define function evaluating the gradients of the objective function at the B
+// columns of the n x B matrix X into the columns of the n x B matrix G.
+// Returns 0 on success and a negative value if the gradient is not available.
+typedef int (*nl_gradients_func)(unsigned n, size_t B, const double *X,
+                                 double *G, void *data);
+
+/*
+ * Estimate the Hessian of the objective function at x from forward
+ * differences of its gradient, with one evaluation of the gradient per group
+ * of columns besides the one at x. Gradients are requested by blocks of
+ * points, so that batch evaluations can be used.
+ *
+ * groups     : NULL to estimate each column separately, or the group (from 0
+ *              to num_groups - 1) of each column; columns of the same group
+ *              are perturbed together and must not share a nonzero row in
+ *              pattern, which is then required
+ * pattern    : NULL, or n x n column-wise, nonzero where the Hessian may be
+ *              nonzero
+ * lb, ub     : bounds, or NULL; steps are taken backwards at upper bounds
+ * H          : n x n, set to the symmetrized estimate
+ *
+ * Memory is allocated with R_alloc. Returns 0 on success and a negative value
+ * if a gradient could not be evaluated.
+ */
+int nl_hessian(nl_gradients_func f, void *data, unsigned n, const double *x,
+               const int *groups, unsigned num_groups, const int *pattern,
+               const double *lb, const double *ub, double *H);
+
+/*
+ * Invert the symmetric positive definite n x n matrix H into C by a Cholesky
+ * factorization (LAPACK dpotrf and dpotri). Returns 0 on success and a
+ * positive value if H is not positive definite.
+ */
+int nl_covariance(unsigned n, const double *H, double *C);
+
+#endif /*__HESSIAN_H__*/
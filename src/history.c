@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   history.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines functions to stream the evaluation history of an
+ * optimization to a binary file with fixed-width records.
+ */
+
+#include "history.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Records are written to disk in blocks of this size.
+#define HISTORY_BUFFER_SIZE (1 << 20)
+
+// Seconds elapsed since the history file was opened.
+static double history_time(const history_writer *h) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)(ts.tv_sec - h->start.tv_sec) +
+         1e-9 * (double)(ts.tv_nsec - h->start.tv_nsec);
+}
+
+int history_open(history_writer *h, const char *path, unsigned n,
+                 unsigned m_ineq, unsigned m_eq, unsigned m_linear_ineq,
+                 unsigned m_linear_eq) {
+  memset(h, 0, sizeof(history_writer));
+  h->n = n;
+  h->m_ineq = m_ineq + m_linear_ineq;
+  h->m_eq = m_eq + m_linear_eq;
+  h->m_linear_ineq = m_linear_ineq;
+  h->m_linear_eq = m_linear_eq;
+  h->width = 4 + n + h->m_ineq + h->m_eq;
+
+  h->file = fopen(path, "wb");
+  if (!h->file) {
+    return 1;
+  }
+  h->buffer = (char *)malloc(HISTORY_BUFFER_SIZE);
+  h->record = (double *)malloc(h->width * sizeof(double));
+  if (!h->buffer || !h->record) {
+    history_close(h);
+    return 1;
+  }
+  setvbuf(h->file, h->buffer, _IOFBF, HISTORY_BUFFER_SIZE);
+
+  char magic[8] = {'N', 'L', 'O', 'P', 'T', 'R', 'H', 1};
+  int32_t header[14] = {HISTORY_VERSION,
+                        0x01020304,
+                        HISTORY_HEADER_SIZE,
+                        (int32_t)h->width,
+                        (int32_t)n,
+                        (int32_t)h->m_ineq,
+                        (int32_t)h->m_eq,
+                        0,
+                        1,
+                        2,
+                        3,
+                        4,
+                        (int32_t)(4 + n),
+                        (int32_t)(4 + n + h->m_ineq)};
+  if (fwrite(magic, 1, sizeof(magic), h->file) != sizeof(magic) ||
+      fwrite(header, sizeof(int32_t), 14, h->file) != 14) {
+    history_close(h);
+    return 1;
+  }
+
+  timespec_get(&h->start, TIME_UTC);
+  return 0;
+}
+
+int history_map(history_writer *h, unsigned k, const double *x_p,
+                const double *Z) {
+  h->x = (double *)malloc(h->n * sizeof(double));
+  if (!h->x) {
+    return 1;
+  }
+  h->k = k;
+  h->x_p = x_p;
+  h->Z = Z;
+  return 0;
+}
+
+// Controls of an evaluation at x, mapped to x_p + Z x if a map is set.
+static const double *history_controls(history_writer *h, const double *x) {
+  if (!h->x_p) {
+    return x;
+  }
+  for (unsigned i = 0; i < h->n; i++) {
+    h->x[i] = h->x_p[i];
+  }
+  for (unsigned j = 0; j < h->k; j++) {
+    const double *z = h->Z + (size_t)j * h->n;
+    for (unsigned i = 0; i < h->n; i++) {
+      h->x[i] += z[i] * x[j];
+    }
+  }
+  return h->x;
+}
+
+// Close the file after a failed write, so that nothing more is written.
+static void history_fail(history_writer *h) {
+  h->failed = 1;
+  fclose(h->file);
+  h->file = NULL;
+}
+
+static void history_flush_record(history_writer *h) {
+  if (h->pending) {
+    h->pending = 0;
+    if (fwrite(h->record, sizeof(double), h->width, h->file) != h->width) {
+      history_fail(h);
+    }
+  }
+}
+
+// Get the pending record for an evaluation at x, starting a new one if x
+// differs or if the field is already set.
+static double *history_record_at(history_writer *h, const double *x,
+                                 int filled, int flags) {
+  x = history_controls(h, x);
+  if (h->pending && !filled &&
+      memcmp(h->record + 4, x, h->n * sizeof(double)) == 0) {
+    h->record[2] = (double)((int)h->record[2] | flags);
+    return h->record;
+  }
+
+  history_flush_record(h);
+  double *r = h->record;
+  r[0] = ++h->num_records;
+  r[1] = history_time(h);
+  r[2] = (double)flags;
+  r[3] = NAN;
+  memcpy(r + 4, x, h->n * sizeof(double));
+  for (unsigned i = 4 + h->n; i < h->width; i++) {
+    r[i] = NAN;
+  }
+  h->pending = 1;
+  h->filled_f = 0;
+  h->filled_ineq = 0;
+  h->filled_eq = 0;
+  h->filled_linear_ineq = 0;
+  h->filled_linear_eq = 0;
+  return r;
+}
+
+void history_objective(history_writer *h, const double *x, double f,
+                       int flags) {
+  if (!h->file) {
+    return;
+  }
+  double *r = history_record_at(h, x, h->filled_f, flags);
+  r[3] = f;
+  h->filled_f = 1;
+}
+
+void history_constraints_ineq(history_writer *h, const double *x,
+                              const double *g, int flags) {
+  if (!h->file) {
+    return;
+  }
+  double *r = history_record_at(h, x, h->filled_ineq, flags);
+  memcpy(r + 4 + h->n, g, (h->m_ineq - h->m_linear_ineq) * sizeof(double));
+  h->filled_ineq = 1;
+}
+
+void history_constraints_eq(history_writer *h, const double *x,
+                            const double *g, int flags) {
+  if (!h->file) {
+    return;
+  }
+  double *r = history_record_at(h, x, h->filled_eq, flags);
+  memcpy(r + 4 + h->n + h->m_ineq, g,
+         (h->m_eq - h->m_linear_eq) * sizeof(double));
+  h->filled_eq = 1;
+}
+
+void history_linear_ineq(history_writer *h, const double *x, const double *g,
+                         int flags) {
+  if (!h->file) {
+    return;
+  }
+  double *r = history_record_at(h, x, h->filled_linear_ineq, flags);
+  memcpy(r + 4 + h->n + h->m_ineq - h->m_linear_ineq, g,
+         h->m_linear_ineq * sizeof(double));
+  h->filled_linear_ineq = 1;
+}
+
+void history_linear_eq(history_writer *h, const double *x, const double *g,
+                       int flags) {
+  if (!h->file) {
+    return;
+  }
+  double *r = history_record_at(h, x, h->filled_linear_eq, flags);
+  memcpy(r + 4 + h->n + h->m_ineq + h->m_eq - h->m_linear_eq, g,
+         h->m_linear_eq * sizeof(double));
+  h->filled_linear_eq = 1;
+}
+
+void history_close(history_writer *h) {
+  if (h->file) {
+    history_flush_record(h);
+  }
+  if (h->file) {
+    if (fclose(h->file) != 0) {
+      h->failed = 1;
+    }
+    h->file = NULL;
+  }
+  free(h->buffer);
+  free(h->record);
+  free(h->x);
+  h->buffer = NULL;
+  h->record = NULL;
+  h->x = NULL;
+}
@@ -0,0 +1,106 @@
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Evaluation history file.
+ *
+ * The file starts with a 64-byte header made of the 8-byte magic string
+ * "NLOPTRH\1" followed by 14 native-endian 32-bit integers:
+ *   version, byte order mark (0x01020304), header size in bytes,
+ *   record size in doubles, n, m_ineq, m_eq,
+ *   offsets (in doubles) of the id, time, flags, f, x, g_ineq and g_eq fields.
+ *
+ * It is followed by fixed-width records of native-endian doubles:
+ *   id      : evaluation number, starting at 1
+ *   time    : seconds elapsed since the start of the optimization
+ *   flags   : 1 if a gradient was requested, + 2 if f was predicted by the
+ *             surrogate model, + 4 if f is the recorded value of an earlier
+ *             evaluation at x (see option surrogate)
+ *   f       : value of the objective function (NaN if not evaluated at x)
+ *   x       : n controls
+ *   g_ineq  : m_ineq inequality constraints, those of eval_g_ineq followed by
+ *             the linear ones (NaN if not evaluated at x)
+ *   g_eq    : m_eq equality constraints, those of eval_g_eq followed by the
+ *             linear ones (NaN if not evaluated at x)
+ *
+ * When the optimization runs over coordinates y with x = x_p + Z y (option
+ * eliminate_linear_eq), the evaluations are mapped back to x before they are
+ * recorded.
+ */
+
+#define HISTORY_VERSION 1
+#define HISTORY_HEADER_SIZE 64
+
+#define HISTORY_FLAG_GRADIENT 1
+#define HISTORY_FLAG_PREDICTED 2
+#define HISTORY_FLAG_CACHED 4
+
+typedef struct {
+  FILE *file;
+  char *buffer;      // stdio buffer, so that records are written in blocks
+  unsigned n;
+  unsigned m_ineq;   // all inequality constraints, the linear ones last
+  unsigned m_eq;     // all equality constraints, the linear ones last
+  unsigned m_linear_ineq;
+  unsigned m_linear_eq;
+  unsigned width;    // record size in doubles
+  double *record;    // pending record
+  int pending;       // 1 if record holds an evaluation not yet written
+  int filled_f;      // whether the fields of the pending record are set
+  int filled_ineq;
+  int filled_eq;
+  int filled_linear_ineq;
+  int filled_linear_eq;
+  unsigned k;        // number of coordinates y, if mapped to x = x_p + Z y
+  const double *x_p; // x_p, or NULL if evaluations are recorded as they are
+  const double *Z;   // Z, n x k stored column-wise
+  double *x;         // workspace: x mapped from y
+  double num_records;
+  int failed;        // 1 if a write failed; the file is then closed
+  struct timespec start;
+} history_writer;
+
+/*
+ * Open path for writing and write the header, for n controls, m_ineq and m_eq
+ * constraints evaluated by R functions, and m_linear_ineq and m_linear_eq
+ * linear constraints. Returns 0 on success.
+ */
+int history_open(history_writer *h, const char *path, unsigned n,
+                 unsigned m_ineq, unsigned m_eq, unsigned m_linear_ineq,
+                 unsigned m_linear_eq);
+
+/*
+ * Record the evaluations at coordinates y of length k as evaluations at
+ * x = x_p + Z y, where Z is n x k stored column-wise. x_p and Z must outlive
+ * the writer. Returns 0 on success.
+ */
+int history_map(history_writer *h, unsigned k, const double *x_p,
+                const double *Z);
+
+/*
+ * Add an evaluation of the objective function or of the inequality or equality
+ * constraints, evaluated by R functions or linear. Evaluations at the same
+ * point x are merged in a single record as long as no field is set twice.
+ */
+void history_objective(history_writer *h, const double *x, double f,
+                       int flags);
+void history_constraints_ineq(history_writer *h, const double *x,
+                              const double *g, int flags);
+void history_constraints_eq(history_writer *h, const double *x,
+                            const double *g, int flags);
+void history_linear_ineq(history_writer *h, const double *x, const double *g,
+                         int flags);
+void history_linear_eq(history_writer *h, const double *x, const double *g,
+                       int flags);
+
+/*
+ * Write the pending record, flush and close the file. Safe to call twice.
+ * Writing stops at the first error, after which h->failed is set and the file
+ * is truncated.
+ */
+void history_close(history_writer *h);
+
+#endif /*__HISTORY_H__*/
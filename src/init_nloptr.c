@@ -30,19 +30,124 @@
  * 2023-08-24: Delete files solely needed for testthat (Avraham Adler).
  * 2024-07-02: Updated old include which is no longer maintained and other
  *             minor code tweaks and efficiency enhancements (Avraham Adler).
+ * 2026-10-18: Registered functions to run optimizations on a background
+ *             thread (Aymeric Stamm).
+ * 2026-10-18: Registered the evaluation of compiled expressions (Aymeric
+ *             Stamm).
+ * 2026-10-18: Registered the versioned table of C functions nloptr_get_api
+ *             (Aymeric Stamm).
+ * 2026-10-18: Added the sampled derivative checker to the table (Aymeric
+ *             Stamm).
+ * 2026-10-18: Registered the generation and screening of Sobol sequences
+ *             (Aymeric Stamm).
+ * 2026-10-18: Registered the process-wide metrics of the optimizations
+ *             (Aymeric Stamm).
  */
 
+#include "async.h"
+#include "checker.h"
+#include "metrics.h"
 #include "nloptr.h"
+#include "nloptrTable.h"
+#include "sobol.h"
 
 #include <R_ext/Rdynload.h>
 #include <stdlib.h> // for NULL
 
 static const R_CallMethodDef CallEntries[] = {
-    {"NLoptR_Optimize", (DL_FUNC)&NLoptR_Optimize, 1}, {NULL, NULL, 0}};
+    {"NLoptR_Metrics", (DL_FUNC)&NLoptR_Metrics, 1},
+    {"NLoptR_Optimize", (DL_FUNC)&NLoptR_Optimize, 1},
+    {"NLoptR_Program_Eval", (DL_FUNC)&NLoptR_Program_Eval, 2},
+    {"NLoptR_Sobol", (DL_FUNC)&NLoptR_Sobol, 4},
+    {NULL, NULL, 0}};
+
+// Table of the functions exported to other packages, see nloptrTable.h.
+static const nloptr_api api = {
+    .version = NLOPTR_API_VERSION,
+    .capabilities = NLOPTR_CAP_ASYNC | NLOPTR_CAP_CHECK | NLOPTR_CAP_SOBOL,
+    .size = sizeof(nloptr_api),
+
+    .nlopt_algorithm_name = &nlopt_algorithm_name,
+    .nlopt_srand = &nlopt_srand,
+    .nlopt_srand_time = &nlopt_srand_time,
+    .nlopt_version = &nlopt_version,
+    .nlopt_create = &nlopt_create,
+    .nlopt_destroy = &nlopt_destroy,
+    .nlopt_copy = &nlopt_copy,
+    .nlopt_optimize = &nlopt_optimize,
+    .nlopt_set_min_objective = &nlopt_set_min_objective,
+    .nlopt_set_max_objective = &nlopt_set_max_objective,
+    .nlopt_set_precond_min_objective = &nlopt_set_precond_min_objective,
+    .nlopt_set_precond_max_objective = &nlopt_set_precond_max_objective,
+    .nlopt_get_algorithm = &nlopt_get_algorithm,
+    .nlopt_get_dimension = &nlopt_get_dimension,
+    .nlopt_set_lower_bounds = &nlopt_set_lower_bounds,
+    .nlopt_set_lower_bounds1 = &nlopt_set_lower_bounds1,
+    .nlopt_get_lower_bounds = &nlopt_get_lower_bounds,
+    .nlopt_set_upper_bounds = &nlopt_set_upper_bounds,
+    .nlopt_set_upper_bounds1 = &nlopt_set_upper_bounds1,
+    .nlopt_get_upper_bounds = &nlopt_get_upper_bounds,
+    .nlopt_remove_inequality_constraints = &nlopt_remove_inequality_constraints,
+    .nlopt_add_inequality_constraint = &nlopt_add_inequality_constraint,
+    .nlopt_add_precond_inequality_constraint =
+        &nlopt_add_precond_inequality_constraint,
+    .nlopt_add_inequality_mconstraint = &nlopt_add_inequality_mconstraint,
+    .nlopt_remove_equality_constraints = &nlopt_remove_equality_constraints,
+    .nlopt_add_equality_constraint = &nlopt_add_equality_constraint,
+    .nlopt_add_precond_equality_constraint =
+        &nlopt_add_precond_equality_constraint,
+    .nlopt_add_equality_mconstraint = &nlopt_add_equality_mconstraint,
+    .nlopt_set_stopval = &nlopt_set_stopval,
+    .nlopt_get_stopval = &nlopt_get_stopval,
+    .nlopt_set_ftol_rel = &nlopt_set_ftol_rel,
+    .nlopt_get_ftol_rel = &nlopt_get_ftol_rel,
+    .nlopt_set_ftol_abs = &nlopt_set_ftol_abs,
+    .nlopt_get_ftol_abs = &nlopt_get_ftol_abs,
+    .nlopt_set_xtol_rel = &nlopt_set_xtol_rel,
+    .nlopt_get_xtol_rel = &nlopt_get_xtol_rel,
+    .nlopt_set_xtol_abs1 = &nlopt_set_xtol_abs1,
+    .nlopt_set_xtol_abs = &nlopt_set_xtol_abs,
+    .nlopt_get_xtol_abs = &nlopt_get_xtol_abs,
+    .nlopt_set_x_weights1 = &nlopt_set_x_weights1,
+    .nlopt_set_x_weights = &nlopt_set_x_weights,
+    .nlopt_get_x_weights = &nlopt_get_x_weights,
+    .nlopt_set_maxeval = &nlopt_set_maxeval,
+    .nlopt_get_maxeval = &nlopt_get_maxeval,
+    .nlopt_set_maxtime = &nlopt_set_maxtime,
+    .nlopt_get_maxtime = &nlopt_get_maxtime,
+    .nlopt_force_stop = &nlopt_force_stop,
+    .nlopt_set_force_stop = &nlopt_set_force_stop,
+    .nlopt_get_force_stop = &nlopt_get_force_stop,
+    .nlopt_set_local_optimizer = &nlopt_set_local_optimizer,
+    .nlopt_set_population = &nlopt_set_population,
+    .nlopt_get_population = &nlopt_get_population,
+    .nlopt_set_vector_storage = &nlopt_set_vector_storage,
+    .nlopt_get_vector_storage = &nlopt_get_vector_storage,
+    .nlopt_set_default_initial_step = &nlopt_set_default_initial_step,
+    .nlopt_set_initial_step = &nlopt_set_initial_step,
+    .nlopt_set_initial_step1 = &nlopt_set_initial_step1,
+    .nlopt_get_initial_step = &nlopt_get_initial_step,
+
+    .nloptr_async_start = &nloptr_async_start,
+    .nloptr_async_poll = &nloptr_async_poll,
+    .nloptr_async_cancel = &nloptr_async_cancel,
+    .nloptr_async_collect = &nloptr_async_collect,
+
+    .nloptr_check_gradient = &nloptr_check_gradient,
+
+    .nloptr_sobol = &nloptr_sobol,
+    .nloptr_sobol_screen = &nloptr_sobol_screen,
+};
+
+static const nloptr_api *nloptr_get_api(void) { return &api; }
 
 void R_init_nloptr(DllInfo *info) {
-  // Register C functions that can be used by external packages
+  // Register the table of C functions that can be used by external packages
   // linking to internal NLopt code from C.
+  R_RegisterCCallable("nloptr", "nloptr_get_api", (DL_FUNC)&nloptr_get_api);
+
+  // Register the same functions individually, for packages built against
+  // earlier versions of nloptrAPI.h.
   R_RegisterCCallable("nloptr", "nlopt_algorithm_name",
                       (DL_FUNC)&nlopt_algorithm_name);
   R_RegisterCCallable("nloptr", "nlopt_srand", (DL_FUNC)&nlopt_srand);
@@ -155,6 +260,16 @@ void R_init_nloptr(DllInfo *info) {
   R_RegisterCCallable("nloptr", "nlopt_get_initial_step",
                       (DL_FUNC)&nlopt_get_initial_step);
 
+  // Register functions to run optimizations on a background thread.
+  R_RegisterCCallable("nloptr", "nloptr_async_start",
+                      (DL_FUNC)&nloptr_async_start);
+  R_RegisterCCallable("nloptr", "nloptr_async_poll",
+                      (DL_FUNC)&nloptr_async_poll);
+  R_RegisterCCallable("nloptr", "nloptr_async_cancel",
+                      (DL_FUNC)&nloptr_async_cancel);
+  R_RegisterCCallable("nloptr", "nloptr_async_collect",
+                      (DL_FUNC)&nloptr_async_collect);
+
   // Register routines to improve lookup from R using .Call interface.
   R_registerRoutines(info, NULL, CallEntries, NULL, NULL);
   R_useDynamicSymbols(info, FALSE);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   linear.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the evaluation of linear constraints in C with BLAS,
+ * which avoids calling back into R for constraints given as matrices.
+ */
+
+#define USE_FC_LEN_T
+
+#include "linear.h"
+
+#include <R.h>
+#include <R_ext/BLAS.h>
+#include <string.h>
+
+#ifndef FCONE
+#define FCONE
+#endif
+
+// Side of the tiles of nl_transpose(): 64 x 64 doubles, i.e. 32 kB read and
+// written per tile.
+#define TRANSPOSE_TILE 64
+
+void nl_transpose(unsigned m, unsigned n, const double *A, double *T) {
+  for (size_t i0 = 0; i0 < m; i0 += TRANSPOSE_TILE) {
+    size_t i1 = i0 + TRANSPOSE_TILE < m ? i0 + TRANSPOSE_TILE : m;
+    for (size_t j0 = 0; j0 < n; j0 += TRANSPOSE_TILE) {
+      size_t j1 = j0 + TRANSPOSE_TILE < n ? j0 + TRANSPOSE_TILE : n;
+      for (size_t i = i0; i < i1; i++) {
+        double *row = T + i * n;
+        for (size_t j = j0; j < j1; j++) {
+          row[j] = A[j * m + i];
+        }
+      }
+    }
+  }
+}
+
+void linear_init(linear_constraints *l, unsigned m, unsigned n,
+                 const double *A, const double *b, double tolerance,
+                 int equality) {
+  l->m = m;
+  l->n = n;
+  l->A = A;
+  l->b = b;
+  l->equality = equality;
+  l->history = NULL;
+  l->jacobian = (double *)R_alloc((size_t)m * n, sizeof(double));
+  l->tolerances = (double *)R_alloc(m, sizeof(double));
+  nl_transpose(m, n, A, l->jacobian);
+  for (size_t i = 0; i < m; i++) {
+    l->tolerances[i] = tolerance;
+  }
+}
+
+void func_constraints_linear(unsigned m, double *constraints, unsigned n,
+                             const double *x, double *grad, void *data) {
+  linear_constraints *l = (linear_constraints *)data;
+
+  // constraints = A x - b.
+  const int M = m, N = n, one = 1;
+  const double alpha = 1.0, beta = -1.0;
+  memcpy(constraints, l->b, m * sizeof(double));
+  F77_CALL(dgemv)("N", &M, &N, &alpha, l->A, &M, x, &one, &beta, constraints,
+                  &one FCONE);
+
+  // The Jacobian is constant.
+  if (grad) {
+    memcpy(grad, l->jacobian, (size_t)m * n * sizeof(double));
+  }
+
+  // Record the evaluation.
+  if (l->history) {
+    int flags = grad ? HISTORY_FLAG_GRADIENT : 0;
+    if (l->equality) {
+      history_linear_eq(l->history, x, constraints, flags);
+    } else {
+      history_linear_ineq(l->history, x, constraints, flags);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef __LINEAR_H__
+#define __LINEAR_H__
+
+#include "history.h"
+
+// Define structure that contains data to pass to the linear constraint
+// function, i.e. the constraints A x - b with a constant m x n matrix A.
+typedef struct {
+  unsigned m;         // number of constraints
+  unsigned n;         // number of controls
+  const double *A;    // A stored column-wise, as received from R
+  const double *b;    // right-hand side
+  double *jacobian;   // A stored row-wise, as expected by NLopt
+  double *tolerances; // tolerance of each constraint
+  int equality;       // whether the constraints are A x - b = 0
+  history_writer *history; // evaluation history, or NULL
+} linear_constraints;
+
+/*
+ * Copy the m x n matrix A, stored column-wise as in R, into T stored row-wise
+ * as the Jacobians of NLopt. The copy runs by square tiles, so that both the
+ * rows read and the rows written stay in the cache when m and n are large.
+ */
+void nl_transpose(unsigned m, unsigned n, const double *A, double *T);
+
+/*
+ * Initialize linear constraints from the m x n matrix A (column-wise) and the
+ * vector b. The Jacobian is converted to the row-wise layout of NLopt once,
+ * here. Evaluations are not recorded until history is set. All memory is allocated with R_alloc, so that it is reclaimed at the
+ * end of the .Call.
+ */
+void linear_init(linear_constraints *l, unsigned m, unsigned n,
+                 const double *A, const double *b, double tolerance,
+                 int equality);
+
+/*
+ * Evaluate the linear constraints A x - b, and their Jacobian if grad is not
+ * NULL, without calling back into R. Has the signature of nlopt_mfunc.
+ */
+void func_constraints_linear(unsigned m, double *constraints, unsigned n,
+                             const double *x, double *grad, void *data);
+
+#endif /*__LINEAR_H__*/
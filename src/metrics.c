@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   metrics.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the process-wide registry of metrics of the calls to
+ * NLoptR_Optimize: number of calls by algorithm and status, evaluations,
+ * callback and setup times, and a histogram of the latencies. Counters are
+ * C11 atomics updated once per call, and times are kept in nanoseconds.
+ */
+
+#include "metrics.h"
+#include "nloptr.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Statuses, from NLOPT_FORCED_STOP (-5) to NL_METRICS_ERROR.
+#define NUM_STATUSES (NL_METRICS_ERROR - NLOPT_FORCED_STOP + 1)
+
+static const char *status_names[NUM_STATUSES] = {
+    "NLOPT_FORCED_STOP",
+    "NLOPT_ROUNDOFF_LIMITED",
+    "NLOPT_OUT_OF_MEMORY",
+    "NLOPT_INVALID_ARGS",
+    "NLOPT_FAILURE",
+    "0", // not an NLopt result
+    "NLOPT_SUCCESS",
+    "NLOPT_STOPVAL_REACHED",
+    "NLOPT_FTOL_REACHED",
+    "NLOPT_XTOL_REACHED",
+    "NLOPT_MAXEVAL_REACHED",
+    "NLOPT_MAXTIME_REACHED",
+    "error"};
+
+static const char *function_names[NL_METRICS_NUM_FUNCTIONS] = {
+    "objective", "inequality", "equality"};
+
+// Upper bounds of the buckets of the latency histogram, in seconds, the last
+// one being +Inf.
+#define NUM_BUCKETS 12
+static const double bucket_bounds[NUM_BUCKETS - 1] = {
+    0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60, 300};
+
+static atomic_ullong solves[NLOPT_NUM_ALGORITHMS][NUM_STATUSES];
+static atomic_ullong evaluations[NL_METRICS_NUM_FUNCTIONS];
+static atomic_ullong callback_ns;
+static atomic_ullong setup_ns;
+static atomic_ullong latency_buckets[NUM_BUCKETS]; // not cumulative
+static atomic_ullong latency_ns;
+
+static void add(atomic_ullong *counter, unsigned long long value) {
+  atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static unsigned long long nanoseconds(double seconds) {
+  return seconds > 0 ? (unsigned long long)(1e9 * seconds + 0.5) : 0;
+}
+
+void nl_metrics_start(nl_metrics_solve *s) {
+  timespec_get(&s->start, TIME_UTC);
+  s->setup_seconds = 0;
+  s->callback_seconds = 0;
+  for (int k = 0; k < NL_METRICS_NUM_FUNCTIONS; k++) {
+    s->evaluations[k] = 0;
+  }
+}
+
+double nl_metrics_elapsed(const nl_metrics_solve *s) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)(ts.tv_sec - s->start.tv_sec) +
+         1e-9 * (double)(ts.tv_nsec - s->start.tv_nsec);
+}
+
+void nl_metrics_record(const nl_metrics_solve *s, nlopt_algorithm algorithm,
+                       int status) {
+  double latency = nl_metrics_elapsed(s);
+
+  // Calls with an invalid algorithm are only counted in the histogram.
+  if ((int)algorithm >= 0 && algorithm < NLOPT_NUM_ALGORITHMS &&
+      status >= NLOPT_FORCED_STOP && status <= NL_METRICS_ERROR) {
+    add(&solves[algorithm][status - NLOPT_FORCED_STOP], 1);
+  }
+  for (int k = 0; k < NL_METRICS_NUM_FUNCTIONS; k++) {
+    add(&evaluations[k], s->evaluations[k]);
+  }
+  add(&callback_ns, nanoseconds(s->callback_seconds));
+  add(&setup_ns, nanoseconds(s->setup_seconds));
+
+  int bucket = 0;
+  while (bucket < NUM_BUCKETS - 1 && latency > bucket_bounds[bucket]) {
+    bucket++;
+  }
+  add(&latency_buckets[bucket], 1);
+  add(&latency_ns, nanoseconds(latency));
+}
+
+// Value of a counter, set to zero if reset is set.
+static double read_counter(atomic_ullong *counter, int reset) {
+  return (double)(reset ? atomic_exchange(counter, 0)
+                        : atomic_load_explicit(counter, memory_order_relaxed));
+}
+
+SEXP NLoptR_Metrics(SEXP R_reset) {
+  int reset = asLogical(R_reset) == TRUE;
+
+  // Read the counters of the solves first, so that the non-zero ones can be
+  // listed.
+  double counts[NLOPT_NUM_ALGORITHMS][NUM_STATUSES];
+  int num_solves = 0;
+  for (int a = 0; a < NLOPT_NUM_ALGORITHMS; a++) {
+    for (int k = 0; k < NUM_STATUSES; k++) {
+      counts[a][k] = read_counter(&solves[a][k], reset);
+      num_solves += counts[a][k] > 0;
+    }
+  }
+
+  SEXP R_algorithm = PROTECT(allocVector(STRSXP, num_solves));
+  SEXP R_status = PROTECT(allocVector(STRSXP, num_solves));
+  SEXP R_count = PROTECT(allocVector(REALSXP, num_solves));
+  int i = 0;
+  for (int a = 0; a < NLOPT_NUM_ALGORITHMS; a++) {
+    for (int k = 0; k < NUM_STATUSES; k++) {
+      if (counts[a][k] > 0) {
+        SET_STRING_ELT(R_algorithm, i,
+                       mkChar(getAlgorithmName((nlopt_algorithm)a)));
+        SET_STRING_ELT(R_status, i, mkChar(status_names[k]));
+        REAL(R_count)[i] = counts[a][k];
+        i++;
+      }
+    }
+  }
+  const char *solves_names[] = {"algorithm", "status", "count", ""};
+  SEXP R_solves = PROTECT(mkNamed(VECSXP, solves_names));
+  SET_VECTOR_ELT(R_solves, 0, R_algorithm);
+  SET_VECTOR_ELT(R_solves, 1, R_status);
+  SET_VECTOR_ELT(R_solves, 2, R_count);
+
+  SEXP R_evaluations = PROTECT(allocVector(REALSXP, NL_METRICS_NUM_FUNCTIONS));
+  SEXP R_function_names =
+      PROTECT(allocVector(STRSXP, NL_METRICS_NUM_FUNCTIONS));
+  for (int k = 0; k < NL_METRICS_NUM_FUNCTIONS; k++) {
+    REAL(R_evaluations)[k] = read_counter(&evaluations[k], reset);
+    SET_STRING_ELT(R_function_names, k, mkChar(function_names[k]));
+  }
+  setAttrib(R_evaluations, R_NamesSymbol, R_function_names);
+
+  // Cumulative counts of the histogram.
+  SEXP R_le = PROTECT(allocVector(REALSXP, NUM_BUCKETS));
+  SEXP R_bucket = PROTECT(allocVector(REALSXP, NUM_BUCKETS));
+  double total = 0;
+  for (int k = 0; k < NUM_BUCKETS; k++) {
+    REAL(R_le)[k] = k < NUM_BUCKETS - 1 ? bucket_bounds[k] : R_PosInf;
+    total += read_counter(&latency_buckets[k], reset);
+    REAL(R_bucket)[k] = total;
+  }
+  const char *latency_names[] = {"le", "bucket", "sum", "count", ""};
+  SEXP R_latency = PROTECT(mkNamed(VECSXP, latency_names));
+  SET_VECTOR_ELT(R_latency, 0, R_le);
+  SET_VECTOR_ELT(R_latency, 1, R_bucket);
+  SET_VECTOR_ELT(R_latency, 2,
+                 ScalarReal(1e-9 * read_counter(&latency_ns, reset)));
+  SET_VECTOR_ELT(R_latency, 3, ScalarReal(total));
+
+  const char *names[] = {"solves",        "evaluations", "callback_seconds",
+                         "setup_seconds", "latency",     ""};
+  SEXP R_metrics = PROTECT(mkNamed(VECSXP, names));
+  SET_VECTOR_ELT(R_metrics, 0, R_solves);
+  SET_VECTOR_ELT(R_metrics, 1, R_evaluations);
+  SET_VECTOR_ELT(R_metrics, 2,
+                 ScalarReal(1e-9 * read_counter(&callback_ns, reset)));
+  SET_VECTOR_ELT(R_metrics, 3,
+                 ScalarReal(1e-9 * read_counter(&setup_ns, reset)));
+  SET_VECTOR_ELT(R_metrics, 4, R_latency);
+
+  UNPROTECT(10);
+  return R_metrics;
+}
@@ -0,0 +1,63 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stddef.h>
+#include <time.h>
+
+#include <Rinternals.h>
+#include <nlopt.h>
+
+/*
+ * Process-wide metrics of the calls to NLoptR_Optimize, accumulated since the
+ * package was loaded (or since the last reset) in atomic counters, so that
+ * optimizations run from several threads can record them concurrently.
+ *
+ * Each call fills an nl_metrics_solve on its stack, then adds it to the
+ * registry once, with nl_metrics_record.
+ */
+
+// Functions whose evaluations are counted.
+#define NL_METRICS_OBJECTIVE 0
+#define NL_METRICS_INEQ 1
+#define NL_METRICS_EQ 2
+#define NL_METRICS_NUM_FUNCTIONS 3
+
+// Status of the calls interrupted by an error in R (or by the user), which
+// return no NLopt result.
+#define NL_METRICS_ERROR (NLOPT_MAXTIME_REACHED + 1)
+
+typedef struct {
+  struct timespec start;   // entry into NLoptR_Optimize
+  double setup_seconds;    // from start to the call of nlopt_optimize
+  double callback_seconds; // spent evaluating the objective and constraints
+  size_t evaluations[NL_METRICS_NUM_FUNCTIONS];
+} nl_metrics_solve;
+
+// Start the clock of a call, and clear its counters.
+void nl_metrics_start(nl_metrics_solve *s);
+
+// Seconds elapsed since nl_metrics_start.
+double nl_metrics_elapsed(const nl_metrics_solve *s);
+
+/*
+ * Add a call of the given algorithm and status (an nlopt_result, or
+ * NL_METRICS_ERROR) to the registry, with its latency: the time elapsed since
+ * nl_metrics_start.
+ */
+void nl_metrics_record(const nl_metrics_solve *s, nlopt_algorithm algorithm,
+                       int status);
+
+/*
+ * .Call entry: list of the metrics, with elements
+ *   solves           : list of algorithm, status and count of the non-zero
+ *                      counters
+ *   evaluations      : named numbers of evaluations of each function
+ *   callback_seconds : time spent evaluating the functions
+ *   setup_seconds    : time spent before the calls of nlopt_optimize
+ *   latency          : list of le (upper bounds of the buckets, in seconds),
+ *                      bucket (cumulative counts), sum and count
+ * The counters are set to zero as they are read if R_reset is TRUE.
+ */
+SEXP NLoptR_Metrics(SEXP R_reset);
+
+#endif /*__METRICS_H__*/
@@ -48,6 +48,7 @@
 #include "parsers.h"
 #include <R.h>
 #include <stdbool.h>
+#include <string.h>
 
 // The algtable table must be in sorted order for bsearch to work properly.
 ALGPAIR algtable[] = {
@@ -243,6 +244,145 @@ nlopt_algorithm getAlgorithmCode(const char *algorithm_str) {
   return algorithm;
 }
 
+const char *getAlgorithmName(nlopt_algorithm algorithm) {
+  for (size_t i = 0; i < sizeof algtable / sizeof algtable[0]; i++) {
+    if (getAlgorithmCode(algtable[i].key) == algorithm) {
+      return algtable[i].key;
+    }
+  }
+  return "NLOPT_UNKNOWN";
+}
+
+// Whether algorithm needs the gradient of the objective function. These are
+// the algorithms for which is.nloptr requires eval_grad_f.
+static int algorithm_uses_gradient(nlopt_algorithm algorithm) {
+  switch (algorithm) {
+  case NLOPT_GD_MLSL:
+  case NLOPT_GD_MLSL_LDS:
+  case NLOPT_GD_STOGO:
+  case NLOPT_GD_STOGO_RAND:
+  case NLOPT_LD_AUGLAG:
+  case NLOPT_LD_AUGLAG_EQ:
+  case NLOPT_LD_CCSAQ:
+  case NLOPT_LD_LBFGS:
+  case NLOPT_LD_LBFGS_NOCEDAL:
+  case NLOPT_LD_MMA:
+  case NLOPT_LD_SLSQP:
+  case NLOPT_LD_TNEWTON:
+  case NLOPT_LD_TNEWTON_PRECOND:
+  case NLOPT_LD_TNEWTON_PRECOND_RESTART:
+  case NLOPT_LD_TNEWTON_RESTART:
+  case NLOPT_LD_VAR1:
+  case NLOPT_LD_VAR2:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// Evaluate the R function R_eval_f at x, and its gradient if grad is not
+// NULL.
+static double eval_R_objective(func_objective_data *d, unsigned n,
+                               const double *x, double *grad) {
+  // Allocate memory for a vector of reals. This vector will contain the
+  // elements of x, where x is the argument to the R function R_eval_f.
+  SEXP rargs = allocVector(REALSXP, n);
+  memcpy(REAL(rargs), x, n * sizeof(double));
+
+  // Evaluate R function R_eval_f with the control x as an argument.
+  SEXP Rcall = PROTECT(lang2(d->R_eval_f, rargs));
+  SEXP result = PROTECT(eval(Rcall, d->R_environment));
+
+  // Recode the return value from SEXP to double.
+  double obj_value;
+  if (isNumeric(result)) {
+    // Objective value is the only element of "result".
+    obj_value = asReal(result);
+  } else {
+    // Objective value needs to be extracted from the list of return values.
+    SEXP R_obj_value = PROTECT(getListElement(result, "objective"));
+
+    // Recode the return value from SEXP to double.
+    obj_value = asReal(R_obj_value);
+
+    UNPROTECT(1);
+  }
+
+  // Handle gradient.
+  if (grad) {
+    // result needs to be a list in this case
+    SEXP R_gradient = PROTECT(getListElement(result, "gradient"));
+
+    // Recode the return value from SEXP to double.
+    memcpy(grad, REAL(R_gradient), n * sizeof(double));
+
+    UNPROTECT(1);
+  }
+
+  UNPROTECT(2);
+
+  return obj_value;
+}
+
+// Objective functions without gradient, called by the derivative checker.
+static double check_R_objective(unsigned n, const double *x, double *grad,
+                                void *data) {
+  return eval_R_objective((func_objective_data *)data, n, x, NULL);
+}
+
+static double check_compiled_objective(unsigned n, const double *x,
+                                       double *grad, void *data) {
+  return nl_compiled_objective((nl_compiled *)data, x, NULL);
+}
+
+// Gradients of the objective function at the columns of X, for the estimation
+// of the Hessian. These evaluations are not counted as iterations.
+static int hessian_R_gradients(unsigned n, size_t B, const double *X,
+                               double *G, void *data) {
+  func_objective_data *d = (func_objective_data *)data;
+  for (size_t b = 0; b < B; b++) {
+    SEXP rargs = PROTECT(allocVector(REALSXP, n));
+    memcpy(REAL(rargs), X + b * n, n * sizeof(double));
+    SEXP Rcall = PROTECT(lang2(d->R_eval_f, rargs));
+    SEXP result = PROTECT(eval(Rcall, d->R_environment));
+    SEXP R_gradient =
+        TYPEOF(result) == VECSXP ? getListElement(result, "gradient")
+                                 : R_NilValue;
+    if (!isReal(R_gradient) || length(R_gradient) != n) {
+      UNPROTECT(3);
+      return -1;
+    }
+    memcpy(G + b * n, REAL(R_gradient), n * sizeof(double));
+    UNPROTECT(3);
+  }
+  return 0;
+}
+
+// Compiled gradients are evaluated at all columns of X at once by the stack
+// machine.
+static int hessian_compiled_gradients(unsigned n, size_t B, const double *X,
+                                      double *G, void *data) {
+  nl_compiled *c = (nl_compiled *)data;
+  if (!c->gradient) {
+    return -1;
+  }
+  int stack_size = 1;
+  for (size_t j = 0; j < n; j++) {
+    if (c->gradient[j].stack_size > stack_size) {
+      stack_size = c->gradient[j].stack_size;
+    }
+  }
+  double *stack = (double *)R_alloc((size_t)stack_size * B, sizeof(double));
+  double *out = (double *)R_alloc(B, sizeof(double));
+  for (size_t j = 0; j < n; j++) {
+    nl_program_eval(&c->gradient[j], n, X, B, out, stack);
+    for (size_t b = 0; b < B; b++) {
+      G[b * n + j] = out[b];
+    }
+  }
+  return 0;
+}
+
 double func_objective(unsigned n, const double *x, double *grad, void *data) {
   // Return the value, and the gradient if necessary, of the objective function.
 
@@ -272,53 +412,49 @@ double func_objective(unsigned n, const double *x, double *grad, void *data) {
     }
   }
 
-  // Allocate memory for a vector of reals. This vector will contain the
-  // elements of x, where x is the argument to the R function R_eval_f.
-  SEXP rargs = allocVector(REALSXP, n);
-  double *prargs = REAL(rargs);
-  for (size_t i = 0; i < n; i++) {
-    prargs[i] = x[i];
+  // Skip the evaluation if the surrogate model predicts that x is not
+  // promising, or if x was already evaluated. Gradient requests always need a
+  // true evaluation.
+  double f_pred;
+  int screened =
+      d->surrogate && !grad ? surrogate_screen(d->surrogate, x, &f_pred) : 0;
+  if (screened) {
+    int cached = screened == SURROGATE_CACHED;
+    if (d->print_level >= 1) {
+      Rprintf("\tf(x) = %f (%s)\n", f_pred, cached ? "cached" : "predicted");
+    }
+    if (d->history) {
+      history_objective(d->history, x, f_pred,
+                        cached ? HISTORY_FLAG_CACHED : HISTORY_FLAG_PREDICTED);
+    }
+    return f_pred;
   }
 
-  // Evaluate R function R_eval_f with the control x as an argument.
-  SEXP Rcall = PROTECT(lang2(d->R_eval_f, rargs));
-  SEXP result = PROTECT(eval(Rcall, d->R_environment));
-
-  // Recode the return value from SEXP to double.
-  double obj_value;
-  if (isNumeric(result)) {
-    // Objective value is the only element of "result".
-    obj_value = asReal(result);
-  } else {
-    // Objective value needs to be extracted from the list of return values.
-    SEXP R_obj_value = PROTECT(getListElement(result, "objective"));
-
-    // Recode the return value from SEXP to double.
-    obj_value = asReal(R_obj_value);
-
-    UNPROTECT(1);
-  }
+  // Compiled objective functions are evaluated without calling R.
+  double t = nl_metrics_elapsed(d->metrics);
+  double obj_value = d->compiled ? nl_compiled_objective(d->compiled, x, grad)
+                                 : eval_R_objective(d, n, x, grad);
+  d->metrics->callback_seconds += nl_metrics_elapsed(d->metrics) - t;
+  d->metrics->evaluations[NL_METRICS_OBJECTIVE]++;
 
   // Print objective value.
   if (d->print_level >= 1) {
     Rprintf("\tf(x) = %f\n", obj_value);
   }
 
-  // Handle gradient.
-  if (grad) {
-    // result needs to be a list in this case
-    SEXP R_gradient = PROTECT(getListElement(result, "gradient"));
-
-    // Recode the return value from SEXP to double.
-    double *pRgrad = REAL(R_gradient);
-    for (size_t i = 0; i < n; i++) {
-      grad[i] = pRgrad[i];
-    }
-
-    UNPROTECT(1);
+  // Compare the gradient with finite differences if a check is due.
+  if (grad && d->checker) {
+    nl_check_point(d->checker, n, x, obj_value, grad, d->num_iterations);
   }
 
-  UNPROTECT(2);
+  // Record the true evaluation.
+  if (d->surrogate) {
+    surrogate_add(d->surrogate, x, obj_value);
+  }
+  if (d->history) {
+    history_objective(d->history, x, obj_value,
+                      grad ? HISTORY_FLAG_GRADIENT : 0);
+  }
 
   return obj_value;
 }
@@ -335,32 +471,26 @@ void func_constraints_ineq(unsigned m, double *constraints, unsigned n,
   // Allocate memory for a vector of reals. This vector will contain the
   // elements of x, where x is the argument to the R function R_eval_f.
   SEXP rargs_x = allocVector(REALSXP, n);
-  double *prargsx = REAL(rargs_x);
-  for (size_t i = 0; i < n; i++) {
-    prargsx[i] = x[i];
-  }
+  memcpy(REAL(rargs_x), x, n * sizeof(double));
 
   // Evaluate R function R_eval_g with the control x as an argument.
   SEXP Rcall = PROTECT(lang2(d->R_eval_g, rargs_x));
+  double t = nl_metrics_elapsed(d->metrics);
   SEXP result = PROTECT(eval(Rcall, d->R_environment));
+  d->metrics->callback_seconds += nl_metrics_elapsed(d->metrics) - t;
+  d->metrics->evaluations[NL_METRICS_INEQ]++;
 
   // Get the value of the constraint from the result.
   if (isNumeric(result)) {
     // Constraint values are the only element of result. so recode the return
-    // value from SEXP to double*, by looping over constraints.
-    double *presult = REAL(result);
-    for (size_t i = 0; i < m; i++) {
-      constraints[i] = presult[i];
-    }
+    // value from SEXP to double*.
+    memcpy(constraints, REAL(result), m * sizeof(double));
   } else {
     // Constraint value should be extracted from the list of return values.
     SEXP R_constraints = PROTECT(getListElement(result, "constraints"));
 
-    // Recode the return value from SEXP to double by looping over constraints.
-    double *pRconst = REAL(R_constraints);
-    for (size_t i = 0; i < m; i++) {
-      constraints[i] = pRconst[i];
-    }
+    // Recode the return value from SEXP to double.
+    memcpy(constraints, REAL(R_constraints), m * sizeof(double));
 
     UNPROTECT(1);
   }
@@ -378,6 +508,12 @@ void func_constraints_ineq(unsigned m, double *constraints, unsigned n,
     }
   }
 
+  // Record the evaluation.
+  if (d->history) {
+    history_constraints_ineq(d->history, x, constraints,
+                           grad ? HISTORY_FLAG_GRADIENT : 0);
+  }
+
   // Get the value of the gradient if needed.
   if (grad) {
     // Result needs to be a list in this case.
@@ -396,14 +532,7 @@ void func_constraints_ineq(unsigned m, double *constraints, unsigned n,
      * dc_m/dx_2, ..., dc_1/dx_n, dc_2/dx_n, ..., dc_m/dx_n] which we have to
      * convert to a row-wise format for NLopt.
      */
-
-    double *pRgrad = REAL(R_gradient);
-    for (size_t i = 0; i < m; i++) {
-      size_t ni = i * n;
-      for (size_t j = 0; j < n; j++) {
-        grad[ni + j] = pRgrad[j * m + i];
-      }
-    }
+    nl_transpose(m, n, REAL(R_gradient), grad);
 
     UNPROTECT(1);
   }
@@ -423,32 +552,26 @@ void func_constraints_eq(unsigned m, double *constraints, unsigned n,
   // Allocate memory for a vector of reals. This vector will contain the
   // elements of x, where x is the argument to the R function R_eval_f.
   SEXP rargs_x = allocVector(REALSXP, n);
-  double *prargsx = REAL(rargs_x);
-  for (size_t i = 0; i < n; i++) {
-    prargsx[i] = x[i];
-  }
+  memcpy(REAL(rargs_x), x, n * sizeof(double));
 
   // Evaluate R function R_eval_g with the control x as an argument.
   SEXP Rcall = PROTECT(lang2(d->R_eval_g, rargs_x));
+  double t = nl_metrics_elapsed(d->metrics);
   SEXP result = PROTECT(eval(Rcall, d->R_environment));
+  d->metrics->callback_seconds += nl_metrics_elapsed(d->metrics) - t;
+  d->metrics->evaluations[NL_METRICS_EQ]++;
 
   // Get the value of the constraint from the result.
   if (isNumeric(result)) {
     // Constraint values are the only element of result, so recode the return
-    // value from SEXP to double*, by looping over constraints.
-    double *presult = REAL(result);
-    for (size_t i = 0; i < m; i++) {
-      constraints[i] = presult[i];
-    }
+    // value from SEXP to double*.
+    memcpy(constraints, REAL(result), m * sizeof(double));
   } else {
     // Constraint value should be extracted from the list of return values.
     SEXP R_constraints = PROTECT(getListElement(result, "constraints"));
 
-    // Recode the return value from SEXP to double by looping over constraints.
-    double *pRconst = REAL(R_constraints);
-    for (size_t i = 0; i < m; i++) {
-      constraints[i] = pRconst[i];
-    }
+    // Recode the return value from SEXP to double.
+    memcpy(constraints, REAL(R_constraints), m * sizeof(double));
 
     UNPROTECT(1);
   }
@@ -467,6 +590,12 @@ void func_constraints_eq(unsigned m, double *constraints, unsigned n,
     }
   }
 
+  // Record the evaluation.
+  if (d->history) {
+    history_constraints_eq(d->history, x, constraints,
+                         grad ? HISTORY_FLAG_GRADIENT : 0);
+  }
+
   // Get the value of the gradient if needed.
   if (grad) {
     // Result needs to be a list in this case.
@@ -485,14 +614,7 @@ void func_constraints_eq(unsigned m, double *constraints, unsigned n,
      * dc_m/dx_2, ..., dc_1/dx_n, dc_2/dx_n, ..., dc_m/dx_n] which we have to
      * convert to a row-wise format for NLopt.
      */
-
-    double *pRgrad = REAL(R_gradient);
-    for (size_t i = 0; i < m; i++) {
-      size_t ni = i * n;
-      for (size_t j = 0; j < n; j++) {
-        grad[ni + j] = pRgrad[j * m + i];
-      }
-    }
+    nl_transpose(m, n, REAL(R_gradient), grad);
 
     UNPROTECT(1);
   }
@@ -624,6 +746,29 @@ nlopt_opt getOptions(SEXP R_options, int num_controls,
     Rprintf("Error: nlopt_set_vector_storage returned NLOPT_INVALID_ARGS.\n");
   }
 
+  // Initial step of derivative-free algorithms. A single non-positive value
+  // keeps the heuristic of NLopt.
+  unsigned int num_initial_step =
+      parse_vector_length_option(R_options, "initial_step");
+  res = NLOPT_SUCCESS;
+  if (num_initial_step == 1) {
+    double initial_step = parse_real_option(R_options, "initial_step");
+    if (initial_step > 0) {
+      res = nlopt_set_initial_step1(opts, initial_step);
+    }
+  } else if (num_initial_step == num_controls) {
+    double *initial_step = parse_real_vector_option(R_options, "initial_step");
+    res = nlopt_set_initial_step(opts, initial_step);
+  } else {
+    *flag_encountered_error = 1;
+    Rprintf("Error: initial_step must have either length 1 or length equal "
+            "to the number of controls.\n");
+  }
+  if (res == NLOPT_INVALID_ARGS) {
+    *flag_encountered_error = 1;
+    Rprintf("Error: nlopt_set_initial_step returned NLOPT_INVALID_ARGS.\n");
+  }
+
   unsigned long ranseed = parse_integer_option(R_options, "ranseed");
   // Set random seed if ranseed > 0. By default a random seed is generated from
   // system time.
@@ -722,9 +867,119 @@ SEXP convertStatusToMessage(nlopt_result status) {
   return R_status_message;
 }
 
+// Return the constraint function to pass to NLopt and set its data: g itself
+// without scaling, or a wrapper evaluating g at the controls corresponding to
+// the normalized controls otherwise.
+static nlopt_mfunc scaledConstraints(scaling_map *map, scaling_constraints *c,
+                                     nlopt_mfunc g, void *g_data,
+                                     void **data) {
+  if (!map) {
+    *data = g_data;
+    return g;
+  }
+  c->map = map;
+  c->g = g;
+  c->g_data = g_data;
+  *data = c;
+  return scaling_constraints_eval;
+}
+
+// Read the linear constraints A x - b from the elements A_name and b_name of
+// args. Returns 0 if there are none. The matrix and the vector are checked and
+// coerced by nloptr() and is.nloptr().
+static int getLinearConstraints(SEXP args, char *A_name, char *b_name,
+                                unsigned int num_controls, double tolerance,
+                                int equality, linear_constraints *l) {
+  SEXP R_A = getListElement(args, A_name);
+  SEXP R_b = getListElement(args, b_name);
+  if (R_A == R_NilValue || length(R_A) == 0) {
+    l->m = 0;
+    return 0;
+  }
+  linear_init(l, length(R_b), num_controls, REAL(R_A), REAL(R_b), tolerance,
+              equality);
+  return 1;
+}
+
 // Constrained minimization: main package function.
+// Arguments and result of nlopt_optimize, run through R_ExecWithCleanup.
+typedef struct {
+  nlopt_opt opts;
+  double *x;
+  double *obj_value;
+  nlopt_result status;
+  scaling_map *scaling; // NULL unless scale_controls or scale_objective is set
+  nlopt_opt local_opts;
+  int scale_objective;
+  int with_gradient;
+  int has_initial_step;
+  history_writer *history;
+  nl_metrics_solve *metrics;
+  int finished; // set when nlopt_optimize returned
+} optimize_data;
+
+static SEXP optimize_body(void *data) {
+  optimize_data *d = (optimize_data *)data;
+  d->metrics->setup_seconds = nl_metrics_elapsed(d->metrics);
+
+  // Map x, the bounds and the tolerances to the normalized problem. The
+  // objective factor needs evaluations of the objective function, hence is
+  // computed here, and they count towards maxeval. At least one evaluation is
+  // left to nlopt_optimize, so that it still returns a point.
+  if (d->scaling) {
+    if (d->scale_objective) {
+      double u[d->scaling->n];
+      scaling_to_u(d->scaling, d->x, u);
+      int num_evals =
+          (int)scaling_set_objective_factor(d->scaling, u, d->with_gradient);
+      int maxeval = nlopt_get_maxeval(d->opts);
+      if (maxeval > 0) {
+        nlopt_set_maxeval(d->opts,
+                          maxeval > num_evals ? maxeval - num_evals : 1);
+      }
+    }
+    nlopt_result res =
+        scaling_apply(d->scaling, d->opts, d->x, d->has_initial_step);
+    if (res >= 0 && d->local_opts) {
+      res = scaling_apply_tolerances(d->scaling, d->local_opts);
+    }
+    if (res < 0) {
+      Rprintf("Error: could not apply the scaling to the options.\n");
+      d->status = NLOPT_INVALID_ARGS;
+      d->finished = 1;
+      return R_NilValue;
+    }
+  }
+
+  d->status = nlopt_optimize(d->opts, d->x, d->obj_value);
+  d->finished = 1;
+
+  // Map the solution back to the controls.
+  if (d->scaling) {
+    scaling_to_x(d->scaling, d->x, d->x);
+    *d->obj_value /= d->scaling->f_scale;
+  }
+  return R_NilValue;
+}
+
+static void optimize_cleanup(void *data) {
+  optimize_data *d = (optimize_data *)data;
+  history_close(d->history);
+
+  // Calls interrupted by an error in R do not return to NLoptR_Optimize, so
+  // their metrics are recorded here.
+  if (!d->finished) {
+    nl_metrics_record(d->metrics, nlopt_get_algorithm(d->opts),
+                      NL_METRICS_ERROR);
+  }
+}
+
 SEXP NLoptR_Optimize(SEXP args) {
 
+  // Start the clock of the process-wide metrics, see metrics.h.
+  nl_metrics_solve metrics;
+  nl_metrics_start(&metrics);
+
   // Declare nlopt_result to capture error codes from setting options.
   nlopt_result res;
   int flag_encountered_error = 0;
@@ -814,6 +1069,36 @@ SEXP NLoptR_Optimize(SEXP args) {
     }
   }
 
+  // Normalize the controls and/or the objective function. The map is set up
+  // from the bounds and x0 here, and applied to the options just before the
+  // optimization.
+  int scale_controls = parse_integer_option(R_options, "scale_controls");
+  int scale_objective = parse_integer_option(R_options, "scale_objective");
+  scaling_map scaling;
+  scaling_map *scaling_ptr = NULL;
+  if (scale_controls || scale_objective) {
+    double lb[num_controls], ub[num_controls];
+    nlopt_get_lower_bounds(opts, lb);
+    nlopt_get_upper_bounds(opts, ub);
+    if (!scale_controls) {
+      // Identity map on the controls.
+      for (size_t i = 0; i < num_controls; i++) {
+        lb[i] = -HUGE_VAL;
+        ub[i] = HUGE_VAL;
+      }
+    }
+    scaling_init(&scaling, num_controls, lb, ub, x0, func_objective, NULL);
+    if (!scale_controls) {
+      for (size_t i = 0; i < num_controls; i++) {
+        scaling.scale[i] = 1.0;
+      }
+    }
+    scaling_ptr = &scaling;
+  }
+  void *constr_data;
+  scaling_constraints scaled_ineq, scaled_eq, scaled_linear_ineq,
+      scaled_linear_eq;
+
   // Get number of inequality constraints.
   unsigned int num_constraints_ineq =
       parse_integer_option(args, "num_constraints_ineq");
@@ -832,12 +1117,146 @@ SEXP NLoptR_Optimize(SEXP args) {
   objfunc_data.R_environment = R_environment;
   objfunc_data.num_iterations = 0;
   objfunc_data.print_level = print_level;
+  objfunc_data.surrogate = NULL;
+  objfunc_data.history = NULL;
+  objfunc_data.compiled = NULL;
+  objfunc_data.checker = NULL;
+  objfunc_data.metrics = &metrics;
+
+  // Objective functions compiled by nl.compile() run on the stack machine.
+  nl_compiled compiled;
+  SEXP R_compiled = getListElement(args, "compiled_f");
+  if (R_compiled != R_NilValue) {
+    if (nl_compiled_init(&compiled, R_compiled, num_controls) != 0) {
+      flag_encountered_error = 1;
+      Rprintf("Error: malformed compiled objective function.\n");
+    }
+    objfunc_data.compiled = &compiled;
+  }
+
+  // Check sampled components or directions of the gradient during the
+  // optimization. Compiled objective functions are evaluated by several
+  // threads, each with its own stack, unless they call the gamma functions of
+  // Rmath, which may warn through R; R functions only by this thread.
+  nl_check_state checker;
+  int check_derivatives_sample =
+      parse_integer_option(R_options, "check_derivatives_sample");
+  if (parse_integer_option(R_options, "check_derivatives") &&
+      check_derivatives_sample > 0) {
+    int every = parse_integer_option(R_options, "check_derivatives_every");
+    int num_threads = parse_integer_option(R_options, "check_derivatives_threads");
+    if (every < 0 || num_threads < 1) {
+      flag_encountered_error = 1;
+      Rprintf("Error: check_derivatives_every must be non-negative and "
+              "check_derivatives_threads positive.\n");
+      every = 0;
+      num_threads = 1;
+    }
+    checker.num_checks = check_derivatives_sample;
+    checker.directional =
+        parse_integer_option(R_options, "check_derivatives_directional");
+    checker.seed = (unsigned long)parse_integer_option(R_options, "ranseed");
+    checker.tol = parse_real_option(R_options, "check_derivatives_tol");
+    checker.every = every;
+    checker.num_gradients = 0;
+    checker.num_points = 0;
+    checker.num_failed = 0;
+    checker.first_failed = 0;
+    checker.max_error = 0.0;
+    checker.buffers = NULL;
+    checker.errors = (double *)R_alloc(num_controls, sizeof(double));
+    checker.worst = (double *)R_alloc(num_controls, sizeof(double));
+    for (size_t i = 0; i < num_controls; i++) {
+      checker.worst[i] = R_NaN;
+    }
+    if (objfunc_data.compiled) {
+      if (!nl_program_thread_safe(&compiled.objective)) {
+        num_threads = 1;
+      }
+      checker.f = check_compiled_objective;
+      checker.num_threads = num_threads;
+      checker.f_data = (void **)R_alloc(num_threads, sizeof(void *));
+      nl_compiled *copies =
+          (nl_compiled *)R_alloc(num_threads, sizeof(nl_compiled));
+      for (int t = 0; t < num_threads; t++) {
+        copies[t] = compiled;
+        copies[t].stack =
+            (double *)R_alloc(compiled.objective.stack_size, sizeof(double));
+        checker.f_data[t] = &copies[t];
+      }
+    } else {
+      checker.f = check_R_objective;
+      checker.num_threads = 1;
+      checker.f_data = (void **)R_alloc(1, sizeof(void *));
+      checker.f_data[0] = &objfunc_data;
+    }
+    objfunc_data.checker = &checker;
+  }
+
+  // Set up surrogate-assisted screening of objective evaluations.
+  surrogate_model surrogate;
+  if (parse_integer_option(R_options, "surrogate")) {
+    double surrogate_margin = parse_real_option(R_options, "surrogate_margin");
+    if (surrogate_margin < 0) {
+      flag_encountered_error = 1;
+      Rprintf("Error: surrogate_margin must be non-negative.\n");
+    }
+    surrogate_init(&surrogate, num_controls, surrogate_margin);
+    objfunc_data.surrogate = &surrogate;
+  }
+
+  // Linear constraints A x <= b and A x = b, evaluated in C.
+
+  // Declare data outside if-statement to prevent data corruption.
+  linear_constraints linear_ineq, linear_eq;
+  double tol_constraints_linear =
+      parse_real_option(R_options, "tol_constraints_linear");
+  int has_linear_ineq =
+      getLinearConstraints(args, "A_ineq", "b_ineq", num_controls,
+                           tol_constraints_linear, 0, &linear_ineq);
+  int has_linear_eq = getLinearConstraints(args, "A_eq", "b_eq", num_controls,
+                                           tol_constraints_linear, 1,
+                                           &linear_eq);
+
+  // Stream the evaluation history to a binary file. The file is closed by
+  // optimize_cleanup, even if the user-defined functions throw an error. With
+  // eliminate_linear_eq, the coordinates y are mapped back to x = x_p + Z y.
+  history_writer history = {NULL};
+  history_writer *history_ptr = NULL;
+  SEXP R_history_file = PROTECT(getListElement(R_options, "history_file"));
+  if (isString(R_history_file) && length(R_history_file) == 1 &&
+      CHAR(STRING_ELT(R_history_file, 0))[0] != '\0') {
+    const char *history_file =
+        R_ExpandFileName(CHAR(STRING_ELT(R_history_file, 0)));
+    SEXP R_basis = getListElement(args, "elimination_basis");
+    SEXP R_offset = getListElement(args, "elimination_offset");
+    unsigned history_n = isMatrix(R_basis) ? nrows(R_basis) : num_controls;
+    if (history_open(&history, history_file, history_n, num_constraints_ineq,
+                     num_constraints_eq, linear_ineq.m, linear_eq.m) != 0 ||
+        (isMatrix(R_basis) &&
+         history_map(&history, num_controls, REAL(R_offset),
+                     REAL(R_basis)) != 0)) {
+      flag_encountered_error = 1;
+      Rprintf("Error: could not open history_file '%s' for writing.\n",
+              history_file);
+    }
+    history_ptr = &history;
+    objfunc_data.history = history_ptr;
+    linear_ineq.history = history_ptr;
+    linear_eq.history = history_ptr;
+  }
+  UNPROTECT(1);
 
   // Unprotect R_eval_f
   UNPROTECT(1);
 
   // Add objective to options.
-  res = nlopt_set_min_objective(opts, func_objective, &objfunc_data);
+  if (scaling_ptr) {
+    scaling.f_data = &objfunc_data;
+    res = nlopt_set_min_objective(opts, scaling_objective, scaling_ptr);
+  } else {
+    res = nlopt_set_min_objective(opts, func_objective, &objfunc_data);
+  }
   if (res == NLOPT_INVALID_ARGS) {
     flag_encountered_error = 1;
     Rprintf("Error: nlopt_set_min_objective returned NLOPT_INVALID_ARGS.\n");
@@ -867,11 +1286,16 @@ SEXP NLoptR_Optimize(SEXP args) {
     ineq_constr_data.R_eval_g = R_eval_g_ineq;
     ineq_constr_data.R_environment = R_environment;
     ineq_constr_data.print_level = print_level;
+    ineq_constr_data.history = history_ptr;
+    ineq_constr_data.metrics = &metrics;
 
     // Add vector-valued inequality constraint.
-    res = nlopt_add_inequality_mconstraint(
-        opts, num_constraints_ineq, func_constraints_ineq, &ineq_constr_data,
-        tol_constraints_ineq_values);
+    nlopt_mfunc constr_func =
+        scaledConstraints(scaling_ptr, &scaled_ineq, func_constraints_ineq,
+                          &ineq_constr_data, &constr_data);
+    res = nlopt_add_inequality_mconstraint(opts, num_constraints_ineq,
+                                           constr_func, constr_data,
+                                           tol_constraints_ineq_values);
     if (res == NLOPT_INVALID_ARGS) {
       flag_encountered_error = 1;
       Rprintf("Error: nlopt_add_inequality_mconstraint returned "
@@ -905,10 +1329,15 @@ SEXP NLoptR_Optimize(SEXP args) {
     eq_constr_data.R_eval_g = R_eval_g_eq;
     eq_constr_data.R_environment = R_environment;
     eq_constr_data.print_level = print_level;
+    eq_constr_data.history = history_ptr;
+    eq_constr_data.metrics = &metrics;
 
     // Add vector-valued equality constraint.
-    res = nlopt_add_equality_mconstraint(opts, num_constraints_eq,
-                                         func_constraints_eq, &eq_constr_data,
+    nlopt_mfunc constr_func =
+        scaledConstraints(scaling_ptr, &scaled_eq, func_constraints_eq,
+                          &eq_constr_data, &constr_data);
+    res = nlopt_add_equality_mconstraint(opts, num_constraints_eq, constr_func,
+                                         constr_data,
                                          tol_constraints_eq_values);
     if (res == NLOPT_INVALID_ARGS) {
       flag_encountered_error = 1;
@@ -920,6 +1349,32 @@ SEXP NLoptR_Optimize(SEXP args) {
     UNPROTECT(1);
   }
 
+  // Add the linear constraints.
+  if (has_linear_ineq) {
+    nlopt_mfunc constr_func =
+        scaledConstraints(scaling_ptr, &scaled_linear_ineq,
+                          func_constraints_linear, &linear_ineq, &constr_data);
+    res = nlopt_add_inequality_mconstraint(opts, linear_ineq.m, constr_func,
+                                           constr_data, linear_ineq.tolerances);
+    if (res == NLOPT_INVALID_ARGS) {
+      flag_encountered_error = 1;
+      Rprintf("Error: nlopt_add_inequality_mconstraint returned "
+              "NLOPT_INVALID_ARGS for the linear constraints.\n");
+    }
+  }
+  if (has_linear_eq) {
+    nlopt_mfunc constr_func =
+        scaledConstraints(scaling_ptr, &scaled_linear_eq,
+                          func_constraints_linear, &linear_eq, &constr_data);
+    res = nlopt_add_equality_mconstraint(opts, linear_eq.m, constr_func,
+                                         constr_data, linear_eq.tolerances);
+    if (res == NLOPT_INVALID_ARGS) {
+      flag_encountered_error = 1;
+      Rprintf("Error: nlopt_add_equality_mconstraint returned "
+              "NLOPT_INVALID_ARGS for the linear constraints.\n");
+    }
+  }
+
   // Unprotect R_environment
   UNPROTECT(1);
 
@@ -932,11 +1387,79 @@ SEXP NLoptR_Optimize(SEXP args) {
   // Do optimization if no error occurred during initialization of the problem.
   nlopt_result status;
   if (flag_encountered_error == 0) {
-    status = nlopt_optimize(opts, x0, &obj_value);
+    optimize_data opt_data = {opts, x0, &obj_value, NLOPT_FAILURE};
+    if (scaling_ptr) {
+      opt_data.scaling = scaling_ptr;
+      opt_data.local_opts = local_opts;
+      opt_data.scale_objective = scale_objective;
+      opt_data.with_gradient =
+          algorithm_uses_gradient(nlopt_get_algorithm(opts));
+      opt_data.has_initial_step =
+          parse_vector_length_option(R_options, "initial_step") > 1 ||
+          parse_real_option(R_options, "initial_step") > 0;
+    }
+    opt_data.history = &history;
+    opt_data.metrics = &metrics;
+    R_ExecWithCleanup(optimize_body, &opt_data, optimize_cleanup, &opt_data);
+    status = opt_data.status;
   } else {
+    history_close(&history);
+    metrics.setup_seconds = nl_metrics_elapsed(&metrics);
     status = NLOPT_INVALID_ARGS;
   }
 
+  // Estimate the Hessian at the solution from differences of gradients, and
+  // the covariance matrix as its inverse.
+  SEXP R_hessian_groups = getListElement(args, "hessian_groups");
+  SEXP R_hessian = R_NilValue;
+  if (R_hessian_groups != R_NilValue && status != NLOPT_INVALID_ARGS) {
+    SEXP R_pattern = getListElement(args, "hessian_pattern");
+    SEXP R_lb = getListElement(args, "lower_bounds");
+    SEXP R_ub = getListElement(args, "upper_bounds");
+    double *lb = (double *)R_alloc(num_controls, sizeof(double));
+    double *ub = (double *)R_alloc(num_controls, sizeof(double));
+    for (size_t i = 0; i < num_controls; i++) {
+      lb[i] = REAL(R_lb)[length(R_lb) == 1 ? 0 : i];
+      ub[i] = REAL(R_ub)[length(R_ub) == 1 ? 0 : i];
+    }
+    int num_groups = 0;
+    for (size_t j = 0; j < num_controls; j++) {
+      if (INTEGER(R_hessian_groups)[j] >= num_groups) {
+        num_groups = INTEGER(R_hessian_groups)[j] + 1;
+      }
+    }
+
+    R_hessian = PROTECT(allocVector(VECSXP, 2));
+    SEXP hessian_names = PROTECT(allocVector(STRSXP, 2));
+    SET_STRING_ELT(hessian_names, 0, mkChar("hessian"));
+    SET_STRING_ELT(hessian_names, 1, mkChar("covariance"));
+    setAttrib(R_hessian, R_NamesSymbol, hessian_names);
+    SEXP R_H = PROTECT(allocMatrix(REALSXP, num_controls, num_controls));
+    int hessian_status = nl_hessian(
+        objfunc_data.compiled ? hessian_compiled_gradients
+                              : hessian_R_gradients,
+        objfunc_data.compiled ? (void *)objfunc_data.compiled
+                              : (void *)&objfunc_data,
+        num_controls, x0, INTEGER(R_hessian_groups), num_groups,
+        R_pattern == R_NilValue ? NULL : LOGICAL(R_pattern), lb, ub, REAL(R_H));
+    if (hessian_status == 0) {
+      SET_VECTOR_ELT(R_hessian, 0, R_H);
+      SEXP R_C = allocMatrix(REALSXP, num_controls, num_controls);
+      SET_VECTOR_ELT(R_hessian, 1, R_C);
+      if (nl_covariance(num_controls, REAL(R_H), REAL(R_C)) != 0) {
+        SET_VECTOR_ELT(R_hessian, 1, R_NilValue);
+      }
+    }
+    UNPROTECT(2);
+  } else {
+    PROTECT(R_hessian);
+  }
+
+  // Add the call to the process-wide metrics.
+  nl_metrics_record(&metrics,
+                    opts ? nlopt_get_algorithm(opts) : NLOPT_NUM_ALGORITHMS,
+                    status);
+
   // Dispose of the nlopt_opt object.
   nlopt_destroy(opts);
   if (use_local_optimizer) {
@@ -948,7 +1471,7 @@ SEXP NLoptR_Optimize(SEXP args) {
   nlopt_version(&major, &minor, &bugfix);
 
   // Create list to return results to R.
-  int num_return_elements = 8;
+  int num_return_elements = 12;
   SEXP R_result_list = PROTECT(allocVector(VECSXP, num_return_elements));
 
   // Attach names to the return list.
@@ -962,6 +1485,10 @@ SEXP NLoptR_Optimize(SEXP args) {
   SET_STRING_ELT(names, 5, mkChar("version_major"));
   SET_STRING_ELT(names, 6, mkChar("version_minor"));
   SET_STRING_ELT(names, 7, mkChar("version_bugfix"));
+  SET_STRING_ELT(names, 8, mkChar("num_predicted"));
+  SET_STRING_ELT(names, 9, mkChar("derivative_checks"));
+  SET_STRING_ELT(names, 10, mkChar("hessian"));
+  SET_STRING_ELT(names, 11, mkChar("num_cached"));
   setAttrib(R_result_list, R_NamesSymbol, names);
 
   // Convert status to an R object.
@@ -998,6 +1525,49 @@ SEXP NLoptR_Optimize(SEXP args) {
   SEXP R_version_bugfix = PROTECT(allocVector(INTSXP, 1));
   INTEGER(R_version_bugfix)[0] = bugfix;
 
+  // Convert the number of evaluations answered by the surrogate model to an
+  // R object.
+  SEXP R_num_predicted = PROTECT(allocVector(INTSXP, 1));
+  INTEGER(R_num_predicted)[0] =
+      objfunc_data.surrogate ? objfunc_data.surrogate->num_predicted : 0;
+
+  // Convert the number of revisits answered from the recorded values to an R
+  // object.
+  SEXP R_num_cached = PROTECT(allocVector(INTSXP, 1));
+  INTEGER(R_num_cached)[0] =
+      objfunc_data.surrogate ? objfunc_data.surrogate->num_cached : 0;
+
+  // Convert the results of the derivative checker to an R object.
+  SEXP R_derivative_checks = R_NilValue;
+  if (objfunc_data.checker) {
+    R_derivative_checks = allocVector(VECSXP, 5);
+    PROTECT(R_derivative_checks);
+    SEXP check_names = PROTECT(allocVector(STRSXP, 5));
+    SET_STRING_ELT(check_names, 0, mkChar("points"));
+    SET_STRING_ELT(check_names, 1, mkChar("errors"));
+    SET_STRING_ELT(check_names, 2, mkChar("first_error"));
+    SET_STRING_ELT(check_names, 3, mkChar("max_relative_error"));
+    SET_STRING_ELT(check_names, 4, mkChar("component_error"));
+    setAttrib(R_derivative_checks, R_NamesSymbol, check_names);
+    SET_VECTOR_ELT(R_derivative_checks, 0,
+                   ScalarInteger((int)checker.num_points));
+    SET_VECTOR_ELT(R_derivative_checks, 1,
+                   ScalarInteger((int)checker.num_failed));
+    SET_VECTOR_ELT(R_derivative_checks, 2,
+                   ScalarInteger(checker.first_failed > 0
+                                     ? (int)checker.first_failed
+                                     : NA_INTEGER));
+    SET_VECTOR_ELT(R_derivative_checks, 3, ScalarReal(checker.max_error));
+    SEXP R_worst = allocVector(REALSXP, num_controls);
+    SET_VECTOR_ELT(R_derivative_checks, 4, R_worst);
+    for (size_t i = 0; i < num_controls; i++) {
+      REAL(R_worst)[i] = checker.worst[i];
+    }
+    UNPROTECT(1);
+  } else {
+    PROTECT(R_derivative_checks);
+  }
+
   // Add elements to the list.
   SET_VECTOR_ELT(R_result_list, 0, R_status);
   SET_VECTOR_ELT(R_result_list, 1, R_status_message);
@@ -1007,6 +1577,18 @@ SEXP NLoptR_Optimize(SEXP args) {
   SET_VECTOR_ELT(R_result_list, 5, R_version_major);
   SET_VECTOR_ELT(R_result_list, 6, R_version_minor);
   SET_VECTOR_ELT(R_result_list, 7, R_version_bugfix);
+  SET_VECTOR_ELT(R_result_list, 8, R_num_predicted);
+  SET_VECTOR_ELT(R_result_list, 9, R_derivative_checks);
+  SET_VECTOR_ELT(R_result_list, 10, R_hessian);
+  SET_VECTOR_ELT(R_result_list, 11, R_num_cached);
+
+  // Report a failed write of the history file, now that the run is over.
+  if (history.failed) {
+    SEXP R_history_file =
+        getListElement(getListElement(args, "options"), "history_file");
+    warning("could not write history_file '%s': the history is truncated.",
+            R_ExpandFileName(CHAR(STRING_ELT(R_history_file, 0))));
+  }
 
   UNPROTECT(num_return_elements + 2);
 
@@ -5,6 +5,15 @@
 
 #include <Rinternals.h>
 
+#include "checker.h"
+#include "compiled.h"
+#include "hessian.h"
+#include "history.h"
+#include "linear.h"
+#include "metrics.h"
+#include "scaling.h"
+#include "surrogate.h"
+
 // Convert the algorithm lookup from a nested if-else chain to a lookup table
 // and switch statement. See https://stackoverflow.com/a/49215742/2726543
 typedef struct {
@@ -17,12 +26,20 @@ int getVal(char *key);
 // Convert passed string to an nlopt_algorithm item.
 nlopt_algorithm getAlgorithmCode(const char *algorithm_str);
 
+// Name of an nlopt_algorithm item, e.g. "NLOPT_LD_MMA", or "NLOPT_UNKNOWN".
+const char *getAlgorithmName(nlopt_algorithm algorithm);
+
 // Define structure that contains data to pass to the objective function
 typedef struct {
   SEXP R_eval_f;
   SEXP R_environment;
   size_t num_iterations;
   int print_level;
+  surrogate_model *surrogate; // NULL unless the surrogate option is set
+  history_writer *history;    // NULL unless the history_file option is set
+  nl_compiled *compiled;      // NULL unless eval_f was compiled
+  nl_check_state *checker;    // NULL unless sampled derivative checks are on
+  nl_metrics_solve *metrics;  // evaluations and callback time of the call
 } func_objective_data;
 
 // Define function that calls user-defined objective function in R
@@ -33,6 +50,8 @@ typedef struct {
   SEXP R_eval_g;
   SEXP R_environment;
   int print_level;
+  history_writer *history;
+  nl_metrics_solve *metrics;
 } func_constraints_ineq_data;
 
 /*
@@ -54,6 +73,8 @@ typedef struct {
   SEXP R_eval_g;
   SEXP R_environment;
   int print_level;
+  history_writer *history;
+  nl_metrics_solve *metrics;
 } func_constraints_eq_data;
 
 /*
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   scaling.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the normalization of the controls and of the objective
+ * function: NLopt works with u such that x = center + scale * u, where the box
+ * defined by the bounds is mapped to the unit box, and with the objective
+ * function multiplied by a constant factor.
+ */
+
+#include "scaling.h"
+
+#include <R.h>
+#include <math.h>
+
+void scaling_init(scaling_map *s, unsigned n, const double *lb,
+                  const double *ub, const double *x0, nlopt_func f,
+                  void *f_data) {
+  s->n = n;
+  s->center = (double *)R_alloc(n, sizeof(double));
+  s->scale = (double *)R_alloc(n, sizeof(double));
+  s->x = (double *)R_alloc(n, sizeof(double));
+  s->f_scale = 1.0;
+  s->f = f;
+  s->f_data = f_data;
+  for (size_t j = 0; j < n; j++) {
+    if (isfinite(lb[j]) && isfinite(ub[j]) && ub[j] > lb[j]) {
+      s->center[j] = lb[j];
+      s->scale[j] = ub[j] - lb[j];
+    } else {
+      s->center[j] = 0.0;
+      s->scale[j] = (x0[j] != 0.0 && isfinite(x0[j])) ? fabs(x0[j]) : 1.0;
+    }
+  }
+}
+
+void scaling_to_u(const scaling_map *s, const double *x, double *u) {
+  for (size_t j = 0; j < s->n; j++) {
+    u[j] = (x[j] - s->center[j]) / s->scale[j];
+  }
+}
+
+void scaling_to_x(const scaling_map *s, const double *u, double *x) {
+  for (size_t j = 0; j < s->n; j++) {
+    x[j] = s->center[j] + s->scale[j] * u[j];
+  }
+}
+
+unsigned scaling_set_objective_factor(scaling_map *s, const double *u0,
+                                      int with_gradient) {
+  unsigned n = s->n;
+  double *grad = (double *)R_alloc(n, sizeof(double));
+  double *x = (double *)R_alloc(n, sizeof(double));
+  scaling_to_x(s, u0, x);
+
+  double norm = 0.0;
+  if (with_gradient) {
+    s->f(n, x, grad, s->f_data);
+    for (size_t j = 0; j < n; j++) {
+      norm = fmax(norm, fabs(grad[j] * s->scale[j]));
+    }
+  } else {
+    // Forward differences with a step of 1e-3 in u.
+    const double h = 1e-3;
+    double f0 = s->f(n, x, NULL, s->f_data);
+    for (size_t j = 0; j < n; j++) {
+      double xj = x[j];
+      x[j] = xj + h * s->scale[j];
+      norm = fmax(norm, fabs(s->f(n, x, NULL, s->f_data) - f0) / h);
+      x[j] = xj;
+    }
+  }
+
+  s->f_scale = (isfinite(norm) && norm > 0.0) ? 1.0 / norm : 1.0;
+  return with_gradient ? 1 : n + 1;
+}
+
+nlopt_result scaling_apply(const scaling_map *s, nlopt_opt opts, double *x0,
+                           int has_initial_step) {
+  unsigned n = s->n;
+  double *work = (double *)R_alloc(n, sizeof(double));
+  nlopt_result res;
+
+  // Bounds: infinite values are left unchanged as the scales are positive.
+  nlopt_get_lower_bounds(opts, work);
+  scaling_to_u(s, work, work);
+  res = nlopt_set_lower_bounds(opts, work);
+  if (res < 0) {
+    return res;
+  }
+  nlopt_get_upper_bounds(opts, work);
+  scaling_to_u(s, work, work);
+  res = nlopt_set_upper_bounds(opts, work);
+  if (res < 0) {
+    return res;
+  }
+
+  // Initial step, only if it was set: NLopt's heuristic then applies to u.
+  if (has_initial_step) {
+    res = nlopt_get_initial_step(opts, x0, work);
+    if (res < 0) {
+      return res;
+    }
+    for (size_t j = 0; j < n; j++) {
+      work[j] /= s->scale[j];
+    }
+    res = nlopt_set_initial_step(opts, work);
+    if (res < 0) {
+      return res;
+    }
+  }
+
+  res = scaling_apply_tolerances(s, opts);
+  if (res < 0) {
+    return res;
+  }
+  scaling_to_u(s, x0, x0);
+  return res;
+}
+
+nlopt_result scaling_apply_tolerances(const scaling_map *s, nlopt_opt opts) {
+  unsigned n = s->n;
+  double *work = (double *)R_alloc(n, sizeof(double));
+  nlopt_result res;
+
+  nlopt_get_xtol_abs(opts, work);
+  for (size_t j = 0; j < n; j++) {
+    work[j] /= s->scale[j];
+  }
+  res = nlopt_set_xtol_abs(opts, work);
+  if (res < 0) {
+    return res;
+  }
+
+  res = nlopt_set_ftol_abs(opts, nlopt_get_ftol_abs(opts) * s->f_scale);
+  if (res < 0) {
+    return res;
+  }
+  return nlopt_set_stopval(opts, nlopt_get_stopval(opts) * s->f_scale);
+}
+
+double scaling_objective(unsigned n, const double *u, double *grad,
+                         void *data) {
+  scaling_map *s = (scaling_map *)data;
+  scaling_to_x(s, u, s->x);
+  double f = s->f(n, s->x, grad, s->f_data);
+  if (grad) {
+    for (size_t j = 0; j < n; j++) {
+      grad[j] *= s->scale[j] * s->f_scale;
+    }
+  }
+  return f * s->f_scale;
+}
+
+void scaling_constraints_eval(unsigned m, double *constraints, unsigned n,
+                              const double *u, double *grad, void *data) {
+  scaling_constraints *c = (scaling_constraints *)data;
+  scaling_map *s = c->map;
+  scaling_to_x(s, u, s->x);
+  c->g(m, constraints, n, s->x, grad, c->g_data);
+  if (grad) {
+    for (size_t i = 0; i < m; i++) {
+      double *row = grad + (size_t)i * n;
+      for (size_t j = 0; j < n; j++) {
+        row[j] *= s->scale[j];
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef __SCALING_H__
+#define __SCALING_H__
+
+#include <nlopt.h>
+
+// Define structure holding the affine map x = center + scale * u between the
+// controls x and the normalized controls u seen by NLopt, and the factor
+// applied to the objective function.
+typedef struct {
+  unsigned n;       // number of controls
+  double *center;   // offset of the map
+  double *scale;    // positive scale of the map
+  double f_scale;   // positive factor applied to the objective function
+  double *x;        // workspace: controls corresponding to u
+  nlopt_func f;     // objective function of x
+  void *f_data;     // data of the objective function
+} scaling_map;
+
+// Define structure that contains data to pass to a constraint function of u.
+typedef struct {
+  scaling_map *map;
+  nlopt_mfunc g;    // constraint function of x
+  void *g_data;     // data of the constraint function
+} scaling_constraints;
+
+/*
+ * Initialize the map from the bounds and the starting point x0. Controls with
+ * finite bounds are mapped to [0, 1]; other controls are divided by the
+ * magnitude of their starting value, or 1 if it is zero. The objective factor
+ * is 1. All memory is allocated with R_alloc.
+ */
+void scaling_init(scaling_map *s, unsigned n, const double *lb,
+                  const double *ub, const double *x0, nlopt_func f,
+                  void *f_data);
+
+/*
+ * Set the objective factor so that the gradient of the scaled objective
+ * function at u0 has unit sup norm. The gradient is requested from the
+ * objective function if with_gradient is nonzero, and approximated by forward
+ * differences otherwise. The factor is left to 1 if the gradient vanishes.
+ * Returns the number of evaluations of the objective function: 1 with the
+ * gradient, n + 1 otherwise.
+ */
+unsigned scaling_set_objective_factor(scaling_map *s, const double *u0,
+                                      int with_gradient);
+
+// Map between x and u.
+void scaling_to_u(const scaling_map *s, const double *x, double *u);
+void scaling_to_x(const scaling_map *s, const double *u, double *x);
+
+/*
+ * Convert the bounds and, if has_initial_step is nonzero, the initial step of
+ * opts from values for x to values for u, as well as the tolerances (see
+ * scaling_apply_tolerances). On success, x0 is mapped to u in place.
+ */
+nlopt_result scaling_apply(const scaling_map *s, nlopt_opt opts, double *x0,
+                           int has_initial_step);
+
+// Convert xtol_abs, ftol_abs and stopval of opts to values for u and for the
+// scaled objective function.
+nlopt_result scaling_apply_tolerances(const scaling_map *s, nlopt_opt opts);
+
+// Objective function of u, with the signature of nlopt_func.
+double scaling_objective(unsigned n, const double *u, double *grad,
+                         void *data);
+
+// Constraint function of u, with the signature of nlopt_mfunc.
+void scaling_constraints_eval(unsigned m, double *constraints, unsigned n,
+                              const double *u, double *grad, void *data);
+
+#endif /*__SCALING_H__*/
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   sobol.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines the generation of Sobol low-discrepancy sequences, with
+ * the primitive polynomials and starting direction numbers of NLopt
+ * (src/util/soboldata.h, copied in soboldata.h), which does not export its own
+ * generator. Points are generated in Gray code order, as by NLopt, but any
+ * point can be reached directly, so that parallel workers can generate
+ * disjoint parts of the sequence.
+ */
+
+#include "sobol.h"
+
+#include <R.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "soboldata.h"
+
+// Number of points evaluated at once by nloptr_sobol_screen().
+#define SOBOL_BLOCK 256
+
+// Direction numbers V[j * dim + i] of bit j of coordinate i, as 32-bit
+// fractions. Returns NULL if memory could not be allocated.
+static uint32_t *sobol_directions(unsigned dim) {
+  uint32_t *V = (uint32_t *)malloc((size_t)32 * dim * sizeof(uint32_t));
+  if (!V) {
+    return NULL;
+  }
+  uint32_t m[32];
+  for (unsigned i = 0; i < dim; i++) {
+    if (i == 0) {
+      for (unsigned j = 0; j < 32; j++) {
+        m[j] = 1;
+      }
+    } else {
+      uint32_t a = sobol_a[i - 1];
+      unsigned d = 0;
+      while (a >>= 1) {
+        d++;
+      }
+      for (unsigned j = 0; j < d; j++) {
+        m[j] = sobol_minit[j][i - 1];
+      }
+      for (unsigned j = d; j < 32; j++) {
+        a = sobol_a[i - 1];
+        m[j] = m[j - d];
+        for (unsigned k = 0; k < d; k++) {
+          m[j] ^= ((a & 1) * m[j - d + k]) << (d - k);
+          a >>= 1;
+        }
+      }
+    }
+    for (unsigned j = 0; j < 32; j++) {
+      V[(size_t)j * dim + i] = m[j] << (31 - j);
+    }
+  }
+  return V;
+}
+
+// Write points first, first + 1, ... of the sequence into X, coordinate i of
+// point b at X[b * point_stride + i * coord_stride]. Point p is the XOR of the
+// direction numbers of the bits of its Gray code, and the Gray codes of
+// successive points differ by a single bit.
+static void sobol_fill(const uint32_t *V, unsigned dim, uint32_t first,
+                       size_t num_points, const double *lb, const double *ub,
+                       double *X, size_t point_stride, size_t coord_stride,
+                       uint32_t *state) {
+  uint32_t gray = first ^ (first >> 1);
+  memset(state, 0, dim * sizeof(uint32_t));
+  for (unsigned j = 0; gray; j++, gray >>= 1) {
+    if (gray & 1) {
+      for (unsigned i = 0; i < dim; i++) {
+        state[i] ^= V[(size_t)j * dim + i];
+      }
+    }
+  }
+
+  uint32_t p = first;
+  for (size_t b = 0; b < num_points; b++, p++) {
+    if (b > 0) {
+      unsigned c = 0;
+      for (uint32_t q = p - 1; q & 1; q >>= 1) {
+        c++;
+      }
+      const uint32_t *v = V + (size_t)c * dim;
+      for (unsigned i = 0; i < dim; i++) {
+        state[i] ^= v[i];
+      }
+    }
+    double *x = X + b * point_stride;
+    for (unsigned i = 0; i < dim; i++) {
+      x[i * coord_stride] =
+          lb[i] + (ub[i] - lb[i]) * ldexp((double)state[i], -32);
+    }
+  }
+}
+
+static int sobol_check(unsigned dim, unsigned long skip, size_t num_points) {
+  if (dim == 0 || dim > NLOPTR_SOBOL_MAXDIM) {
+    return -1;
+  }
+  if (skip > 4294967295UL || num_points > 4294967295UL - skip) {
+    return -1;
+  }
+  return 0;
+}
+
+int nloptr_sobol(unsigned dim, unsigned long skip, size_t num_points,
+                 const double *lb, const double *ub, double *X) {
+  if (sobol_check(dim, skip, num_points) != 0) {
+    return -1;
+  }
+  uint32_t *V = sobol_directions(dim);
+  uint32_t *state = (uint32_t *)malloc(dim * sizeof(uint32_t));
+  if (!V || !state) {
+    free(V);
+    free(state);
+    return -1;
+  }
+  sobol_fill(V, dim, (uint32_t)skip + 1, num_points, lb, ub, X, dim, 1, state);
+  free(V);
+  free(state);
+  return 0;
+}
+
+int nloptr_sobol_screen(nlopt_func f, void *f_data, unsigned dim,
+                        const double *lb, const double *ub, unsigned long skip,
+                        size_t num_points, unsigned k, double *best_x,
+                        double *best_f) {
+  if (k == 0 || sobol_check(dim, skip, num_points) != 0) {
+    return -1;
+  }
+  uint32_t *V = sobol_directions(dim);
+  uint32_t *state = (uint32_t *)malloc(dim * sizeof(uint32_t));
+  double *X = (double *)malloc((size_t)SOBOL_BLOCK * dim * sizeof(double));
+  if (!V || !state || !X) {
+    free(V);
+    free(state);
+    free(X);
+    return -1;
+  }
+
+  unsigned num_kept = 0;
+  for (size_t first = 0; first < num_points; first += SOBOL_BLOCK) {
+    size_t B = num_points - first < SOBOL_BLOCK ? num_points - first
+                                                : SOBOL_BLOCK;
+    sobol_fill(V, dim, (uint32_t)(skip + first + 1), B, lb, ub, X, dim, 1,
+               state);
+    for (size_t b = 0; b < B; b++) {
+      const double *x = X + b * dim;
+      double fx = f(dim, x, NULL, f_data);
+      if (isnan(fx) || (num_kept == k && !(fx < best_f[k - 1]))) {
+        continue;
+      }
+      // Insert into the sorted list of the best points.
+      unsigned pos = num_kept < k ? num_kept++ : k - 1;
+      while (pos > 0 && best_f[pos - 1] > fx) {
+        best_f[pos] = best_f[pos - 1];
+        memcpy(best_x + (size_t)pos * dim, best_x + (size_t)(pos - 1) * dim,
+               dim * sizeof(double));
+        pos--;
+      }
+      best_f[pos] = fx;
+      memcpy(best_x + (size_t)pos * dim, x, dim * sizeof(double));
+    }
+  }
+
+  free(V);
+  free(state);
+  free(X);
+  return num_kept;
+}
+
+SEXP NLoptR_Sobol(SEXP R_num_points, SEXP R_skip, SEXP R_lb, SEXP R_ub) {
+  if (!isReal(R_lb) || !isReal(R_ub) || length(R_lb) != length(R_ub)) {
+    error("lb and ub must be numeric vectors of the same length.");
+  }
+  unsigned dim = length(R_lb);
+  double num_points = asReal(R_num_points);
+  double skip = asReal(R_skip);
+  if (!(num_points >= 0) || !(skip >= 0) ||
+      num_points + skip > 4294967295.0) {
+    error("At most 2^32 - 1 points of the Sobol sequence can be generated.");
+  }
+  if (num_points > INT_MAX) {
+    error("At most %d points can be returned at once.", INT_MAX);
+  }
+  if (dim == 0 || dim > NLOPTR_SOBOL_MAXDIM) {
+    error("The Sobol sequence is available in 1 to %d dimensions.",
+          NLOPTR_SOBOL_MAXDIM);
+  }
+
+  SEXP R_X = PROTECT(allocMatrix(REALSXP, (int)num_points, dim));
+  uint32_t *V = sobol_directions(dim);
+  uint32_t *state = (uint32_t *)R_alloc(dim, sizeof(uint32_t));
+  if (!V) {
+    error("Could not allocate the direction numbers.");
+  }
+  // One point per row.
+  sobol_fill(V, dim, (uint32_t)skip + 1, (size_t)num_points, REAL(R_lb),
+             REAL(R_ub), REAL(R_X), 1, (size_t)num_points, state);
+  free(V);
+  UNPROTECT(1);
+  return R_X;
+}
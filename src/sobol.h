@@ -0,0 +1,43 @@
+#ifndef __SOBOL_H__
+#define __SOBOL_H__
+
+#include <stddef.h>
+
+#include <Rinternals.h>
+#include <nlopt.h>
+
+// Largest dimension of the Sobol sequence.
+#define NLOPTR_SOBOL_MAXDIM 1111
+
+/*
+ * Write points skip + 1, ..., skip + num_points of the Sobol sequence in dim
+ * dimensions, scaled to the box [lb, ub], into the columns of the dim x
+ * num_points matrix X. Point 0, the origin, is never generated, so that the
+ * sequence is the one used by NLOPT_GD_MLSL_LDS. Workers given disjoint ranges
+ * of skip generate disjoint parts of the same sequence.
+ *
+ * Returns 0 on success, and -1 if dim is 0 or larger than NLOPTR_SOBOL_MAXDIM,
+ * or if skip + num_points exceeds 2^32 - 1.
+ */
+int nloptr_sobol(unsigned dim, unsigned long skip, size_t num_points,
+                 const double *lb, const double *ub, double *X);
+
+/*
+ * Evaluate f (without gradient) at points skip + 1, ..., skip + num_points of
+ * the Sobol sequence scaled to [lb, ub], and keep the k points with the lowest
+ * values, sorted by increasing value, in the columns of the dim x k matrix
+ * best_x and in best_f. Points are generated by blocks, so that num_points may
+ * be large. NaN values are discarded.
+ *
+ * Returns the number of points kept, at most k, or -1 on invalid arguments
+ * (including k = 0) or if memory could not be allocated.
+ */
+int nloptr_sobol_screen(nlopt_func f, void *f_data, unsigned dim,
+                        const double *lb, const double *ub, unsigned long skip,
+                        size_t num_points, unsigned k, double *best_x,
+                        double *best_f);
+
+// .Call entry: num_points x dim matrix of Sobol points, one point per row.
+SEXP NLoptR_Sobol(SEXP R_num_points, SEXP R_skip, SEXP R_lb, SEXP R_ub);
+
+#endif /*__SOBOL_H__*/
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Aymeric Stamm. All Rights Reserved.
+ * This code is published under the L-GPL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   surrogate.c
+ * Author: Aymeric Stamm
+ * Date:   18 October 2026
+ *
+ * This file defines a local surrogate model of the objective function, used
+ * to skip true evaluations at points that are predicted not to be promising.
+ */
+
+#include "surrogate.h"
+
+#include <R.h>
+#include <R_ext/Lapack.h>
+#include <math.h>
+#include <string.h>
+
+void surrogate_init(surrogate_model *s, unsigned n, double margin) {
+  s->n = n;
+  s->size = 0;
+  s->capacity = 64;
+  s->x = (double *)R_alloc(s->capacity * n, sizeof(double));
+  s->f = (double *)R_alloc(s->capacity, sizeof(double));
+  s->f_best = HUGE_VAL;
+  s->margin = margin;
+  s->num_nbrs = 2 * (n + 1);
+  s->num_predicted = 0;
+  s->num_cached = 0;
+
+  // The interpolation system has one row per neighbour plus n + 1 rows for
+  // the linear tail.
+  unsigned dim = s->num_nbrs + n + 1;
+  s->nbr_idx = (size_t *)R_alloc(s->num_nbrs, sizeof(size_t));
+  s->nbr_dist = (double *)R_alloc(s->num_nbrs, sizeof(double));
+  s->sys = (double *)R_alloc((size_t)dim * dim, sizeof(double));
+  s->rhs = (double *)R_alloc(dim, sizeof(double));
+  s->ipiv = (int *)R_alloc(dim, sizeof(int));
+}
+
+void surrogate_add(surrogate_model *s, const double *x, double f) {
+  if (!R_FINITE(f)) {
+    return;
+  }
+
+  if (s->size == s->capacity) {
+    // R_alloc memory cannot be reallocated, the old blocks are released at
+    // the end of the .Call.
+    size_t capacity = 2 * s->capacity;
+    double *xs = (double *)R_alloc(capacity * s->n, sizeof(double));
+    double *fs = (double *)R_alloc(capacity, sizeof(double));
+    memcpy(xs, s->x, s->size * s->n * sizeof(double));
+    memcpy(fs, s->f, s->size * sizeof(double));
+    s->x = xs;
+    s->f = fs;
+    s->capacity = capacity;
+  }
+
+  memcpy(s->x + s->size * s->n, x, s->n * sizeof(double));
+  s->f[s->size] = f;
+  s->size++;
+  if (f < s->f_best) {
+    s->f_best = f;
+  }
+}
+
+// Keep the k nearest recorded points to x, sorted by increasing distance.
+static unsigned find_neighbours(surrogate_model *s, const double *x) {
+  unsigned n = s->n, k = 0;
+  for (size_t i = 0; i < s->size; i++) {
+    const double *xi = s->x + i * n;
+    double d = 0.0;
+    for (unsigned j = 0; j < n; j++) {
+      double dj = xi[j] - x[j];
+      d += dj * dj;
+    }
+    d = sqrt(d);
+
+    if (k == s->num_nbrs && d >= s->nbr_dist[k - 1]) {
+      continue;
+    }
+    unsigned pos = k < s->num_nbrs ? k++ : k - 1;
+    while (pos > 0 && s->nbr_dist[pos - 1] > d) {
+      s->nbr_dist[pos] = s->nbr_dist[pos - 1];
+      s->nbr_idx[pos] = s->nbr_idx[pos - 1];
+      pos--;
+    }
+    s->nbr_dist[pos] = d;
+    s->nbr_idx[pos] = i;
+  }
+  return k;
+}
+
+int surrogate_screen(surrogate_model *s, const double *x, double *f_pred) {
+  unsigned n = s->n;
+
+  // Wait for enough evaluations to fit the full model.
+  if (s->size < s->num_nbrs) {
+    return 0;
+  }
+
+  unsigned k = find_neighbours(s, x);
+
+  // The point has already been evaluated.
+  if (s->nbr_dist[0] == 0.0) {
+    *f_pred = s->f[s->nbr_idx[0]];
+    s->num_cached++;
+    return SURROGATE_CACHED;
+  }
+
+  /*
+   * Build the interpolation system in coordinates centred at x
+   *
+   *   | Phi  P | | lambda |   | f |
+   *   | P^T  0 | |   c    | = | 0 |
+   *
+   * with Phi[i, j] = |x_i - x_j|^3 and P[i, ] = (1, x_i - x).
+   */
+  int dim = k + n + 1;
+  double *A = s->sys;
+  memset(A, 0, (size_t)dim * dim * sizeof(double));
+  double f_min = HUGE_VAL, f_max = -HUGE_VAL;
+  for (unsigned i = 0; i < k; i++) {
+    const double *xi = s->x + s->nbr_idx[i] * n;
+    for (unsigned j = 0; j < i; j++) {
+      const double *xj = s->x + s->nbr_idx[j] * n;
+      double r = 0.0;
+      for (unsigned l = 0; l < n; l++) {
+        double dl = xi[l] - xj[l];
+        r += dl * dl;
+      }
+      r = r * sqrt(r);
+      A[i + j * dim] = r;
+      A[j + i * dim] = r;
+    }
+    A[i + k * dim] = 1.0;
+    A[k + i * dim] = 1.0;
+    for (unsigned l = 0; l < n; l++) {
+      A[i + (k + 1 + l) * dim] = xi[l] - x[l];
+      A[(k + 1 + l) + i * dim] = xi[l] - x[l];
+    }
+
+    double fi = s->f[s->nbr_idx[i]];
+    s->rhs[i] = fi;
+    f_min = fi < f_min ? fi : f_min;
+    f_max = fi > f_max ? fi : f_max;
+  }
+  for (int i = k; i < dim; i++) {
+    s->rhs[i] = 0.0;
+  }
+
+  int nrhs = 1, info;
+  F77_CALL(dgesv)(&dim, &nrhs, A, &dim, s->ipiv, s->rhs, &dim, &info);
+  if (info != 0) {
+    // Degenerate neighbourhood (e.g. points on a hyperplane).
+    return 0;
+  }
+
+  // Evaluate the interpolant at x, i.e. at the origin of the local coordinates.
+  double pred = s->rhs[k];
+  for (unsigned i = 0; i < k; i++) {
+    double r = s->nbr_dist[i];
+    pred += s->rhs[i] * r * r * r;
+  }
+  if (!R_FINITE(pred)) {
+    return 0;
+  }
+
+  if (pred > s->f_best + s->margin * (f_max - f_min)) {
+    *f_pred = pred;
+    s->num_predicted++;
+    return SURROGATE_PREDICTED;
+  }
+  return 0;
+}
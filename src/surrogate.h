@@ -0,0 +1,55 @@
+#ifndef __SURROGATE_H__
+#define __SURROGATE_H__
+
+#include <stddef.h>
+
+// Define structure holding the evaluation history and the workspace of the
+// surrogate model used to screen objective evaluations.
+typedef struct {
+  unsigned n;           // number of controls
+  size_t size;          // number of recorded evaluations
+  size_t capacity;      // number of evaluations that fit in x and f
+  double *x;            // recorded points, x[i*n + j]
+  double *f;            // recorded objective values
+  double f_best;        // lowest recorded objective value
+  double margin;        // screening margin, relative to the local spread
+  unsigned num_nbrs;    // number of nearest neighbours used in the model
+  size_t num_predicted; // number of evaluations answered by the model
+  size_t num_cached;    // number of revisits answered by the recorded value
+  size_t *nbr_idx;      // workspace: indices of the nearest neighbours
+  double *nbr_dist;     // workspace: distances of the nearest neighbours
+  double *sys;          // workspace: interpolation system
+  double *rhs;          // workspace: right-hand side and solution
+  int *ipiv;            // workspace: pivots of the LU factorization
+} surrogate_model;
+
+/*
+ * Initialize the surrogate model for n controls. All memory is allocated with
+ * R_alloc, so that it is reclaimed at the end of the .Call even if the user
+ * function throws an error.
+ */
+void surrogate_init(surrogate_model *s, unsigned n, double margin);
+
+// Outcomes of surrogate_screen() when the true evaluation can be skipped.
+#define SURROGATE_PREDICTED 1
+#define SURROGATE_CACHED 2
+
+// Record a true evaluation f(x).
+void surrogate_add(surrogate_model *s, const double *x, double f);
+
+/*
+ * Decide whether the true evaluation of f at x can be skipped.
+ *
+ * A cubic radial basis function interpolant with a linear tail is fitted to
+ * the nearest recorded evaluations and evaluated at x. The evaluation is
+ * skipped when the prediction exceeds the best recorded value by more than
+ * margin times the spread of the neighbouring values, i.e. when x is not
+ * promising.
+ *
+ * Returns SURROGATE_PREDICTED and stores the prediction in f_pred if the
+ * evaluation can be skipped, SURROGATE_CACHED and stores the recorded value in
+ * f_pred if x was already evaluated, 0 otherwise.
+ */
+int surrogate_screen(surrogate_model *s, const double *x, double *f_pred);
+
+#endif /*__SURROGATE_H__*/